@@ -3,16 +3,16 @@
 #pragma once
 
 #include <vector>
+#include <array>
 #include <memory>
 #include <functional>
 #include <unordered_map>
 #include <bitset>
 #include <cstdarg>
 #include <initializer_list>
+#include <stdexcept>
 
 
-#include <librnp/rnp_networkservice.h>
-#include <librnp/rnp_networkmanager.h>
 #include <librnp/rnp_packet.h>
 
 
@@ -21,46 +21,47 @@
 #include "libriccore/util/bitsethelpers.h"
 #include <libriccore/riccorelogging.h>
 
+#include "commandhandlerbase.h"
+
 
 template <typename SYSTEM_T,
           typename COMMAND_ID_ENUM,
           size_t N_MAX_COMMANDS = 256,
           RicCoreLoggingConfig::LOGGERS LOGGING_TARGET = RicCoreLoggingConfig::LOGGERS::SYS>
-class CommandHandler : public RnpNetworkService
+class CommandHandler : public CommandHandlerBase<CommandHandler<SYSTEM_T,COMMAND_ID_ENUM,N_MAX_COMMANDS,LOGGING_TARGET>,
+                                                 SYSTEM_T,COMMAND_ID_ENUM,N_MAX_COMMANDS,LOGGING_TARGET>
 {
-    static_assert(std::is_enum_v<COMMAND_ID_ENUM>, "COMMAND_ID_ENUM template paramter not an enum!");
+    using base_t = CommandHandlerBase<CommandHandler<SYSTEM_T,COMMAND_ID_ENUM,N_MAX_COMMANDS,LOGGING_TARGET>,
+                                      SYSTEM_T,COMMAND_ID_ENUM,N_MAX_COMMANDS,LOGGING_TARGET>;
+    friend base_t;
 
 //type aliases
 public: // public type defintions to make life a bit easier to get types for the command handler
     using commandFunction_t = std::function<void(SYSTEM_T &, const RnpPacketSerialized &)>;
     using commandMap_t = std::unordered_map<COMMAND_ID_ENUM, commandFunction_t>;
-private: 
-    using bitset_t = std::bitset<N_MAX_COMMANDS>;
 
 public:
 
     /**
      * @brief Command handler constructor with default intialization for the default persistent enabled commands
-     * 
+     *
      * @author Kiran de Silva
-     * 
+     *
      * @param sys referece to the derived system object to allow commands to access system objects
      * @param commandMap unordered map from the command id to the function call back for a given command
      * @param ServiceID network service ID
      */
-    CommandHandler(SYSTEM_T &sys,commandMap_t commandMap,const uint8_t ServiceID) : 
-                        RnpNetworkService(ServiceID),
-                        _sys(sys),
-                        _commandMap(commandMap),
-                        _defaultPersistentEnabledCommands(0),
-                        _persistentEnabledCommands(_defaultPersistentEnabledCommands),
-                        _enabledCommands(_persistentEnabledCommands){};
+    CommandHandler(SYSTEM_T &sys,commandMap_t commandMap,const uint8_t ServiceID) :
+                        base_t(sys,ServiceID,0)
+                        {
+                            generateDispatchTable(commandMap);
+                        };
 
     /**
      * @brief  Command handler constructor with support for intializing the default persisnent enabled command bitset.
-     * 
+     *
      * @author Kiran de Silva
-     * 
+     *
      * @tparam T type of element of intializer list
      * @param sys reference to the dervied system object
      * @param commandMap unordered map from the command id to the function call back for a given command
@@ -68,161 +69,97 @@ public:
      * @param defaultPersistCommands intializer list of command ids to always be enabled during system lifetime
      */
     template <class T>
-    CommandHandler(SYSTEM_T &sys,commandMap_t commandMap,const uint8_t ServiceID,const std::initializer_list<T> defaultPersistCommands) : 
-                                                        RnpNetworkService(ServiceID),
-                                                        _sys(sys),
-                                                        _commandMap(commandMap),
-                                                        _defaultPersistentEnabledCommands(RicCoreUtil::BitsetHelpers::generateBitset<N_MAX_COMMANDS>(defaultPersistCommands)),
-                                                        _persistentEnabledCommands(_defaultPersistentEnabledCommands),
-                                                        _enabledCommands(_persistentEnabledCommands)
-                                                        {};
+    CommandHandler(SYSTEM_T &sys,commandMap_t commandMap,const uint8_t ServiceID,const std::initializer_list<T> defaultPersistCommands) :
+                                                        base_t(sys,ServiceID,RicCoreUtil::BitsetHelpers::generateBitset<N_MAX_COMMANDS>(defaultPersistCommands))
+                                                        {
+                                                            generateDispatchTable(commandMap);
+                                                        };
 
-    /**
-     * @brief Commonly used packet types for the command handling service.
-     * 
-     */
-    enum class PACKET_TYPES : uint8_t
+    ~CommandHandler()
     {
-        SIMPLE = 0,
-        MAGCAL = 10,
-        MESSAGE_RESPONSE = 100,
-        TELEMETRY_RESPONSE = 101,
-        LMQTELEMETRY_RESPONSE = 102
+        this->stopDeferredWorker();
     };
 
-    /**
-     * @brief Enable specified commands
-     * 
-     * @author Kiran de Silva
-     * 
-     * @tparam T Type of the list element, can be integral or enum type, however enum type must match COMMAND_ID_ENUM type
-     * @param command_ids initializer list of command ids to be enabled
-     * @param persist enable command and persist throught command bit field resets
-     */
-    template<class T>
-    void enableCommands(const std::initializer_list<T> command_ids,bool persist = false)
-    {
-        static_assert(std::is_integral_v<T> || (std::is_enum_v<T> && std::is_same_v<T,COMMAND_ID_ENUM>),"Enum Type not the same as COMMAND_ID_ENUM template type!");
-        RicCoreUtil::BitsetHelpers::setBits(_enabledCommands,command_ids);
-        if (persist){ 
-            // if we require the command to always be enabled, also set the bit in the persistent Enabled Commands bitset
-            RicCoreUtil::BitsetHelpers::setBits(_persistentEnabledCommands,command_ids);
-        }
-    }
-
-    /**
-     * @brief Disable specified commands  
-     * 
-     * @author Kiran de Silva
-     * 
-     * @tparam T Type of the list element, can be integral or enum type, however enum type must match COMMAND_ID_ENUM type
-     * @param command_ids initializer list of command ids to be enabled
-     * @param persist set true to disable a command which has been enabled persistently
-     */
-    template<class T>
-    void disableCommands(const std::initializer_list<T> command_ids, bool persist = false)
-    {
-        static_assert(std::is_integral_v<T> || (std::is_enum_v<T> && std::is_same_v<T,COMMAND_ID_ENUM>),"Enum Type not the same as COMMAND_ID_ENUM template type!");
-        RicCoreUtil::BitsetHelpers::resetBits(_enabledCommands,command_ids);
-        
-        if (persist){ 
-            // if we want to reset a persistently enabled command, we must also reset the command id in the persistent enabled command bitset
-            RicCoreUtil::BitsetHelpers::resetBits(_persistentEnabledCommands,command_ids);
-        }
-
-        //ensure that persistent enabled commands do not get reset
-        _enabledCommands |= _persistentEnabledCommands;
-        
-    }
-
-    /**
-     * @brief Reset commands to the persistent enabled commands
-     * 
-     * @author Kiran de Silva
-     * 
-     */
-    void resetCommands()
-    {
-        _enabledCommands = _persistentEnabledCommands;
-    }
-
-    /**
-     * @brief Reset persistent enabled commands to the default persistent enabled commands
-     * 
-     * @author Kiran de Silva
-     * 
-     */
-    void resetPersistentCommands()
-    {
-        _persistentEnabledCommands = _defaultPersistentEnabledCommands;
-    }
-
-    
-
 private:
-    /**
-     * @brief Reference to the system class to access objects within the system
-     *
-     */
-    SYSTEM_T &_sys;
 
     /**
-     * @brief Command map which maps the given command id to the releveant function callback
+     * @brief Entry of the dispatch table, the command function and enabled bit of a command are stored together so
+     * handling a command reads a single entry
      *
      */
-    const commandMap_t _commandMap;
+    struct dispatch_entry_t
+    {
+        commandFunction_t function; // empty if no function is registered to the command id
+        bool enabled = false;
+    };
 
     /**
-     * @brief Constant Bitset to store the default persistent enabled commands
-     * 
+     * @brief Dense dispatch table indexed directly by command id
+     *
      */
-    const bitset_t _defaultPersistentEnabledCommands;
+    std::array<dispatch_entry_t, N_MAX_COMMANDS> _dispatchTable;
 
     /**
-     * @brief Bitset to track commands which should persist during resets of the enabled command bitset
+     * @brief Whether a command is enabled, read from the dispatch table
      *
+     * @param cmd
+     * @return true
+     * @return false
      */
-    bitset_t _persistentEnabledCommands;
+    bool commandEnabled(command_t cmd) const
+    {
+        return (cmd < N_MAX_COMMANDS) && _dispatchTable[cmd].enabled;
+    };
 
     /**
-     * @brief Bitset to track enabled and disabled commmands
+     * @brief Mirror the enabled command bitset into the dispatch table
      *
      */
-    bitset_t _enabledCommands;
+    void onEnabledCommandsChanged()
+    {
+        for (size_t i = 0; i < N_MAX_COMMANDS; i++)
+        {
+            _dispatchTable[i].enabled = this->_enabledCommands[i];
+        }
+    };
 
     /**
-     * @brief Process the recevied command packet
+     * @brief Call the command function registered to an enabled command id, if any
      *
-     * @param packetptr
+     * @param cmd
+     * @param packet
+     * @return true command function called
+     * @return false no command function registered
      */
-    void handleCommand(packetptr_t packetptr)
+    bool dispatchCommand(command_t cmd, const RnpPacketSerialized &packet)
     {
-        
-        //Note Command_t is set in the simplecommmandpacket header (librnp) and is considerd to be constant
-        //throughout ricardo avionics
-        command_t cmd = CommandPacket::getCommand(*packetptr); 
-        if (_enabledCommands.test(cmd))
+        const commandFunction_t &function = _dispatchTable[cmd].function;
+        if (!function)
         {
-            if (_commandMap.count(static_cast<COMMAND_ID_ENUM>(cmd)))
-            {
-                _commandMap.at(static_cast<COMMAND_ID_ENUM>(cmd))(_sys, *packetptr);
-            }
+            return false;
         }
-        else {
-            RicCoreLogging::log<LOGGING_TARGET>("Illegal command! Source node: " + std::to_string(packetptr->header.source) + ", command id: " + std::to_string(cmd));
-        }
-        
+        function(this->_sys, packet);
+        return true;
     };
 
     /**
-     * @brief Simply a wrapper for handleCommand function for readability
+     * @brief Flattens the command map into the dispatch table so handling a command is a single array lookup.
+     * Throws std::out_of_range if a command id in the map exceeds N_MAX_COMMANDS.
      *
-     * @param packetptr
+     * @param commandMap
      */
-    void networkCallback(packetptr_t packetptr) override
+    void generateDispatchTable(const commandMap_t &commandMap)
     {
-        handleCommand(std::move(packetptr));
+        for (const auto &[command_id, command_function] : commandMap)
+        {
+            const size_t index = static_cast<size_t>(command_id);
+            if (index >= N_MAX_COMMANDS)
+            {
+                throw std::out_of_range("Command id " + std::to_string(index) + " exceeds N_MAX_COMMANDS!");
+            }
+            _dispatchTable[index].function = command_function;
+        }
+        onEnabledCommandsChanged();
     };
 
-
 };
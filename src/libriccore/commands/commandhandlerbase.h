@@ -0,0 +1,894 @@
+#pragma once
+/**
+ * @file commandhandlerbase.h
+ * @brief CRTP base of the command handlers. Implements the rnp service, the enabled command bitsets and illegal
+ * command logging, the derived handler only has to implement how a command id is dispatched to its command function
+ * by providing bool dispatchCommand(command_t, const RnpPacketSerialized&). A derived handler which keeps the enabled
+ * bit next to its command function can also provide bool commandEnabled(command_t) and
+ * void onEnabledCommandsChanged() to mirror the enabled command bitset into its own table.
+ * Commands flagged as deferred are queued and executed on a worker thread so long running commands (flash erase,
+ * calibration etc) don't stall the main loop. The progress of deferred commands is reported back to the sender as
+ * COMMAND_STATUS_RESPONSE packets from update(). Execution time statistics are kept for every command.
+ * BATCH packets carry several simple commands which are dispatched in order in one pass, with a single
+ * BATCH_RESPONSE packet returned.
+ * Commands can be rate limited with a per command token bucket, and replayed packets suppressed by remembering the
+ * (source, uid) of recently handled packets in a fixed table. Rejected commands are counted and summarised in the log
+ * at most once per REJECTION_LOG_INTERVAL rather than logged individually, so a command storm can't flood the log.
+ */
+
+#include <memory>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <bitset>
+#include <initializer_list>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+
+#include <librnp/rnp_networkservice.h>
+#include <librnp/rnp_networkmanager.h>
+#include <librnp/rnp_packet.h>
+
+
+#include <librnp/default_packets/simplecommandpacket.h>
+
+#include "libriccore/util/bitsethelpers.h"
+#include <libriccore/riccorelogging.h>
+#include <libriccore/platform/millis.h>
+#include <libriccore/threading/riccorethread.h>
+#include <libriccore/platform/riccorethread_types.h>
+#include <libriccore/threading/uniqueptrchannel.h>
+#include <libriccore/packets/binarypacket.h>
+
+
+template <typename DERIVED,
+          typename SYSTEM_T,
+          typename COMMAND_ID_ENUM,
+          size_t N_MAX_COMMANDS,
+          RicCoreLoggingConfig::LOGGERS LOGGING_TARGET>
+class CommandHandlerBase : public RnpNetworkService
+{
+    static_assert(std::is_enum_v<COMMAND_ID_ENUM>, "COMMAND_ID_ENUM template paramter not an enum!");
+
+protected:
+    using bitset_t = std::bitset<N_MAX_COMMANDS>;
+
+public:
+    /**
+     * @brief Commonly used packet types for the command handling service.
+     *
+     */
+    enum class PACKET_TYPES : uint8_t
+    {
+        SIMPLE = 0,
+        BATCH = 1,
+        MAGCAL = 10,
+        MESSAGE_RESPONSE = 100,
+        TELEMETRY_RESPONSE = 101,
+        LMQTELEMETRY_RESPONSE = 102,
+        COMMAND_STATUS_RESPONSE = 103,
+        BATCH_RESPONSE = 104
+    };
+
+    /**
+     * @brief Result of each entry of a batch, reported in a BATCH_RESPONSE packet.
+     * BATCH packet payload: {uint8 command id, uint32 arg}[N], i.e N simple command packet bodies.
+     * BATCH_RESPONSE packet payload: uint16 entry count, {uint8 command id, uint8 result}[count].
+     * The packet uid is the uid of the batch packet.
+     *
+     */
+    enum class BATCH_RESULT : uint8_t
+    {
+        EXECUTED = 0,
+        DEFERRED = 1, // queued on the deferred worker, progress is reported with COMMAND_STATUS_RESPONSE packets
+        DISABLED = 2,
+        UNKNOWN = 3, // no command function registered
+        REJECTED = 4, // deferred queue full
+        RATE_LIMITED = 5
+    };
+
+    /**
+     * @brief Number of rejected commands by reason
+     *
+     */
+    struct rejection_counts_t
+    {
+        uint32_t disabled;
+        uint32_t rate_limited;
+        uint32_t duplicate; // whole packets suppressed
+        uint32_t queue_full;
+    };
+
+    /**
+     * @brief Maximum number of commands with a rate limit
+     *
+     */
+    static constexpr size_t N_RATE_LIMITS = 16;
+
+    /**
+     * @brief Number of recently handled packets remembered for duplicate suppression
+     *
+     */
+    static constexpr size_t N_DUPLICATE_ENTRIES = 32;
+
+    /**
+     * @brief Minimum time between rejected command log summaries [ms]
+     *
+     */
+    static constexpr uint32_t REJECTION_LOG_INTERVAL = 1000;
+
+    /**
+     * @brief Status of a deferred command reported in a COMMAND_STATUS_RESPONSE packet.
+     * Packet payload: uint8 command id, uint8 status, uint32 execution time [us] (only valid when COMPLETED).
+     * The packet uid is the uid of the command packet.
+     *
+     */
+    enum class COMMAND_STATUS : uint8_t
+    {
+        QUEUED = 0,
+        STARTED = 1,
+        COMPLETED = 2,
+        REJECTED = 3 // deferred queue full
+    };
+
+    /**
+     * @brief Execution time statistics of a command
+     *
+     */
+    struct command_stats_t
+    {
+        uint32_t count;          // number of executions
+        uint32_t max_time;       // longest execution time [us]
+        uint64_t cumulative_time; // total execution time [us]
+    };
+
+    /**
+     * @brief Enable specified commands
+     *
+     * @author Kiran de Silva
+     *
+     * @tparam T Type of the list element, can be integral or enum type, however enum type must match COMMAND_ID_ENUM type
+     * @param command_ids initializer list of command ids to be enabled
+     * @param persist enable command and persist throught command bit field resets
+     */
+    template<class T>
+    void enableCommands(const std::initializer_list<T> command_ids,bool persist = false)
+    {
+        static_assert(std::is_integral_v<T> || (std::is_enum_v<T> && std::is_same_v<T,COMMAND_ID_ENUM>),"Enum Type not the same as COMMAND_ID_ENUM template type!");
+        RicCoreUtil::BitsetHelpers::setBits(_enabledCommands,command_ids);
+        if (persist){
+            // if we require the command to always be enabled, also set the bit in the persistent Enabled Commands bitset
+            RicCoreUtil::BitsetHelpers::setBits(_persistentEnabledCommands,command_ids);
+        }
+        static_cast<DERIVED*>(this)->onEnabledCommandsChanged();
+    }
+
+    /**
+     * @brief Disable specified commands
+     *
+     * @author Kiran de Silva
+     *
+     * @tparam T Type of the list element, can be integral or enum type, however enum type must match COMMAND_ID_ENUM type
+     * @param command_ids initializer list of command ids to be enabled
+     * @param persist set true to disable a command which has been enabled persistently
+     */
+    template<class T>
+    void disableCommands(const std::initializer_list<T> command_ids, bool persist = false)
+    {
+        static_assert(std::is_integral_v<T> || (std::is_enum_v<T> && std::is_same_v<T,COMMAND_ID_ENUM>),"Enum Type not the same as COMMAND_ID_ENUM template type!");
+        RicCoreUtil::BitsetHelpers::resetBits(_enabledCommands,command_ids);
+
+        if (persist){
+            // if we want to reset a persistently enabled command, we must also reset the command id in the persistent enabled command bitset
+            RicCoreUtil::BitsetHelpers::resetBits(_persistentEnabledCommands,command_ids);
+        }
+
+        //ensure that persistent enabled commands do not get reset
+        _enabledCommands |= _persistentEnabledCommands;
+        static_cast<DERIVED*>(this)->onEnabledCommandsChanged();
+
+    }
+
+    /**
+     * @brief Reset commands to the persistent enabled commands
+     *
+     * @author Kiran de Silva
+     *
+     */
+    void resetCommands()
+    {
+        _enabledCommands = _persistentEnabledCommands;
+        static_cast<DERIVED*>(this)->onEnabledCommandsChanged();
+    }
+
+    /**
+     * @brief Reset persistent enabled commands to the default persistent enabled commands
+     *
+     * @author Kiran de Silva
+     *
+     */
+    void resetPersistentCommands()
+    {
+        _persistentEnabledCommands = _defaultPersistentEnabledCommands;
+    }
+
+    /**
+     * @brief Flag commands as long running so they are executed on the deferred worker thread instead of inside the
+     * network callback. Deferred command functions run concurrently with the main loop so must only touch thread safe
+     * parts of the system.
+     *
+     * @tparam T Type of the list element, can be integral or enum type, however enum type must match COMMAND_ID_ENUM type
+     * @param command_ids initializer list of command ids to defer
+     */
+    template<class T>
+    void deferCommands(const std::initializer_list<T> command_ids)
+    {
+        static_assert(std::is_integral_v<T> || (std::is_enum_v<T> && std::is_same_v<T,COMMAND_ID_ENUM>),"Enum Type not the same as COMMAND_ID_ENUM template type!");
+        RicCoreUtil::BitsetHelpers::setBits(_deferredCommands,command_ids);
+    }
+
+    /**
+     * @brief Configure the deferred worker thread, must be called before the first deferred command is received as
+     * the worker is started on demand.
+     *
+     * @param stackSize worker stack size [bytes]
+     * @param priority worker priority, see RicCoreThread::Thread for how this maps onto unix scheduling
+     * @param coreID worker core affinity
+     * @param maxQueued maximum number of deferred commands waiting to execute, further commands are rejected
+     */
+    void configureDeferredWorker(size_t stackSize,int priority,RicCoreThread::Thread::CORE_ID coreID,size_t maxQueued)
+    {
+        _workerStackSize = stackSize;
+        _workerPriority = priority;
+        _workerCoreID = coreID;
+        _maxDeferredCommands = maxQueued;
+    }
+
+    /**
+     * @brief Limit the rate a command can be executed at using a token bucket. The bucket holds up to burst tokens
+     * and gains one token every interval, each execution uses a token. Throws std::runtime_error if more than
+     * N_RATE_LIMITS commands are rate limited.
+     *
+     * @tparam T integral or COMMAND_ID_ENUM
+     * @param command_id
+     * @param burst maximum number of executions in quick succession
+     * @param interval time to regain one execution [ms]
+     */
+    template<class T>
+    void setRateLimit(T command_id, uint16_t burst, uint32_t interval)
+    {
+        static_assert(std::is_integral_v<T> || (std::is_enum_v<T> && std::is_same_v<T,COMMAND_ID_ENUM>),"Enum Type not the same as COMMAND_ID_ENUM template type!");
+        const command_t cmd = static_cast<command_t>(command_id);
+
+        rate_limit_t *limit = findRateLimit(cmd);
+        if (limit == nullptr)
+        {
+            if (_numRateLimits == N_RATE_LIMITS)
+            {
+                throw std::runtime_error("Maximum number of command rate limits exceeded!");
+            }
+            limit = &_rateLimits[_numRateLimits++];
+        }
+
+        *limit = rate_limit_t{cmd, burst, burst, interval, millis()};
+        _rateLimitedCommands.set(cmd);
+    }
+
+    /**
+     * @brief Set the window over which packets with the same source and uid are treated as replays and dropped,
+     * 0 disables duplicate suppression. Only enable if all senders increment the packet uid.
+     *
+     * @param window [ms]
+     */
+    void setDuplicateWindow(uint32_t window)
+    {
+        _duplicateWindow = window;
+        _duplicates = {};
+    }
+
+    /**
+     * @brief Get the number of rejected commands since construction
+     *
+     * @return const rejection_counts_t&
+     */
+    const rejection_counts_t &getRejectionCounts() const
+    {
+        return _rejectionCounts;
+    }
+
+    /**
+     * @brief Records the execution time of completed deferred commands and sends any pending deferred command
+     * status and batch response packets. Logs a summary of rejected commands if any occured since the last summary.
+     * Call from the main loop.
+     *
+     */
+    void update()
+    {
+        std::unique_ptr<command_status_t> status;
+        while ((status = _statusQueue.pop()) != nullptr)
+        {
+            if (status->status == COMMAND_STATUS::COMPLETED)
+            {
+                recordExecution(status->command, status->execution_time);
+            }
+            sendStatus(*status);
+        }
+
+        for (BinaryPacket &response : _pendingResponses)
+        {
+            response.header.source = _sys.networkmanager.getAddress();
+            _sys.networkmanager.sendPacket(response);
+        }
+        _pendingResponses.clear();
+
+        logRejections();
+    }
+
+    /**
+     * @brief Get the execution statistics of a command
+     *
+     * @tparam T integral or COMMAND_ID_ENUM
+     * @param command_id
+     * @return const command_stats_t&
+     */
+    template<class T>
+    const command_stats_t &getCommandStats(T command_id) const
+    {
+        static_assert(std::is_integral_v<T> || (std::is_enum_v<T> && std::is_same_v<T,COMMAND_ID_ENUM>),"Enum Type not the same as COMMAND_ID_ENUM template type!");
+        return _commandStats.at(static_cast<size_t>(command_id));
+    }
+
+    /**
+     * @brief Reset execution statistics of all commands
+     *
+     */
+    void resetCommandStats()
+    {
+        _commandStats = {};
+    }
+
+protected:
+    /**
+     * @brief Construct the command handler base
+     *
+     * @param sys referece to the derived system object to allow commands to access system objects
+     * @param ServiceID network service ID
+     * @param defaultPersistentEnabledCommands
+     */
+    CommandHandlerBase(SYSTEM_T &sys,const uint8_t ServiceID,const bitset_t defaultPersistentEnabledCommands) :
+                        RnpNetworkService(ServiceID),
+                        _sys(sys),
+                        _defaultPersistentEnabledCommands(defaultPersistentEnabledCommands),
+                        _persistentEnabledCommands(_defaultPersistentEnabledCommands),
+                        _enabledCommands(_persistentEnabledCommands),
+                        _deferredCommands(0),
+                        _commandStats(),
+                        _workerStackSize(8192),
+                        _workerPriority(1),
+                        _workerCoreID(RicCoreThread::Thread::CORE_ID::ANYCORE),
+                        _maxDeferredCommands(8),
+                        _stopWorker(false),
+                        _rateLimitedCommands(0),
+                        _rateLimits(),
+                        _numRateLimits(0),
+                        _duplicateWindow(0),
+                        _duplicates(),
+                        _duplicateHead(0),
+                        _rejectionCounts(),
+                        _reportedRejectionCounts(),
+                        _lastRejectionLog(0),
+                        _lastRejectedSource(0),
+                        _lastRejectedCommand(0){};
+
+    /**
+     * @brief Whether a command is enabled, may be hidden by the derived handler
+     *
+     * @param cmd
+     * @return true
+     * @return false
+     */
+    bool commandEnabled(command_t cmd) const
+    {
+        return (cmd < N_MAX_COMMANDS) && _enabledCommands[cmd];
+    };
+
+    /**
+     * @brief Called after the enabled command bitset changes, may be hidden by the derived handler
+     *
+     */
+    void onEnabledCommandsChanged(){};
+
+    /**
+     * @brief Stops the deferred worker. Must be called from the derived destructor as deferred commands are
+     * dispatched through the derived class.
+     *
+     */
+    void stopDeferredWorker()
+    {
+        _stopWorker = true;
+        _deferredPending.give(); // wake the worker so it sees the stop request
+        _worker.reset();
+    };
+
+    /**
+     * @brief Reference to the system class to access objects within the system
+     *
+     */
+    SYSTEM_T &_sys;
+
+    /**
+     * @brief Constant Bitset to store the default persistent enabled commands
+     *
+     */
+    const bitset_t _defaultPersistentEnabledCommands;
+
+    /**
+     * @brief Bitset to track commands which should persist during resets of the enabled command bitset
+     *
+     */
+    bitset_t _persistentEnabledCommands;
+
+    /**
+     * @brief Bitset to track enabled and disabled commmands
+     *
+     */
+    bitset_t _enabledCommands;
+
+    /**
+     * @brief Bitset of commands to execute on the deferred worker
+     *
+     */
+    bitset_t _deferredCommands;
+
+    std::array<command_stats_t,N_MAX_COMMANDS> _commandStats;
+
+    /**
+     * @brief Status update of a deferred command passed from the worker back to the main loop
+     *
+     */
+    struct command_status_t
+    {
+        command_t command;
+        COMMAND_STATUS status;
+        uint32_t execution_time;
+        uint16_t uid;
+        uint8_t source;
+        uint8_t source_service;
+        uint8_t destination_service;
+    };
+
+    size_t _workerStackSize;
+    int _workerPriority;
+    RicCoreThread::Thread::CORE_ID _workerCoreID;
+    size_t _maxDeferredCommands;
+
+    std::atomic<bool> _stopWorker;
+
+    RicCoreThread::UniquePtrChannel<RnpPacketSerialized> _deferredQueue;
+
+    /**
+     * @brief Counts commands queued for the deferred worker, the worker blocks on it while the queue is empty
+     *
+     */
+    RicCoreThread::Semaphore_t _deferredPending;
+    RicCoreThread::UniquePtrChannel<command_status_t> _statusQueue;
+
+    /**
+     * @brief Worker thread, started on the first deferred command
+     *
+     */
+    std::unique_ptr<RicCoreThread::Thread> _worker;
+
+    /**
+     * @brief Responses generated while handling commands, sent on the next update
+     *
+     */
+    std::vector<BinaryPacket> _pendingResponses;
+
+    struct rate_limit_t
+    {
+        command_t command;
+        uint16_t capacity;
+        uint16_t tokens;
+        uint32_t interval; // time to regain a token [ms]
+        uint32_t last_refill; // [ms]
+    };
+
+    /**
+     * @brief Bitset of commands with a rate limit, so commands without one skip the rate limit lookup
+     *
+     */
+    bitset_t _rateLimitedCommands;
+    std::array<rate_limit_t,N_RATE_LIMITS> _rateLimits;
+    size_t _numRateLimits;
+
+    struct duplicate_entry_t
+    {
+        uint32_t time; // [ms]
+        uint16_t uid;
+        uint8_t source;
+        bool valid;
+    };
+
+    uint32_t _duplicateWindow;
+
+    /**
+     * @brief Ring of recently handled packets, the oldest entry is overwritten
+     *
+     */
+    std::array<duplicate_entry_t,N_DUPLICATE_ENTRIES> _duplicates;
+    size_t _duplicateHead;
+
+    rejection_counts_t _rejectionCounts;
+    rejection_counts_t _reportedRejectionCounts;
+    uint32_t _lastRejectionLog;
+    uint8_t _lastRejectedSource;
+    command_t _lastRejectedCommand;
+
+    /**
+     * @brief Process the recevied command packet
+     *
+     * @param packetptr
+     */
+    void handleCommand(packetptr_t packetptr)
+    {
+
+        if (isDuplicate(packetptr->header))
+        {
+            ++_rejectionCounts.duplicate;
+            _lastRejectedSource = packetptr->header.source;
+            return;
+        }
+
+        if (packetptr->header.type == static_cast<uint8_t>(PACKET_TYPES::BATCH))
+        {
+            handleBatch(*packetptr);
+            return;
+        }
+
+        //Note Command_t is set in the simplecommmandpacket header (librnp) and is considerd to be constant
+        //throughout ricardo avionics
+        command_t cmd = CommandPacket::getCommand(*packetptr);
+        executeCommand(cmd, packetptr);
+
+    };
+
+    /**
+     * @brief Execute a single command if it is enabled, either immediately or by queueing it on the deferred worker
+     *
+     * @param cmd
+     * @param packetptr moved from if the command is deferred
+     * @return BATCH_RESULT
+     */
+    BATCH_RESULT executeCommand(command_t cmd, packetptr_t &packetptr)
+    {
+        if (!static_cast<DERIVED*>(this)->commandEnabled(cmd))
+        {
+            ++_rejectionCounts.disabled;
+            recordRejection(packetptr->header.source, cmd);
+            return BATCH_RESULT::DISABLED;
+        }
+
+        if (_rateLimitedCommands[cmd] && !consumeToken(cmd))
+        {
+            ++_rejectionCounts.rate_limited;
+            recordRejection(packetptr->header.source, cmd);
+            return BATCH_RESULT::RATE_LIMITED;
+        }
+
+        if (_deferredCommands[cmd])
+        {
+            const uint8_t source = packetptr->header.source;
+            if (!deferCommand(std::move(packetptr)))
+            {
+                if (_rateLimitedCommands[cmd])
+                {
+                    refundToken(cmd); // the command never ran so shouldn't count against its rate limit
+                }
+                ++_rejectionCounts.queue_full;
+                recordRejection(source, cmd);
+                return BATCH_RESULT::REJECTED;
+            }
+            return BATCH_RESULT::DEFERRED;
+        }
+
+        const uint32_t start = micros();
+        if (!static_cast<DERIVED*>(this)->dispatchCommand(cmd, *packetptr))
+        {
+            return BATCH_RESULT::UNKNOWN;
+        }
+        recordExecution(cmd, micros() - start);
+        return BATCH_RESULT::EXECUTED;
+    };
+
+    /**
+     * @brief Execute every entry of a batch packet in order. Each entry is rewrapped as a simple command packet
+     * with the header of the batch so command functions handle it exactly as if it was sent on its own.
+     * A single BATCH_RESPONSE packet with the result of every entry is queued for the sender.
+     *
+     * @param batch
+     */
+    void handleBatch(const RnpPacketSerialized &batch)
+    {
+        constexpr size_t entrySize = SimpleCommandPacket::size();
+        const size_t payloadSize = (batch.packet.size() > RnpHeader::size()) ? batch.packet.size() - RnpHeader::size() : 0;
+        const size_t entryCount = std::min<size_t>(payloadSize / entrySize, std::numeric_limits<uint16_t>::max());
+
+        RnpHeader entryHeader = batch.header;
+        entryHeader.type = static_cast<uint8_t>(PACKET_TYPES::SIMPLE);
+        entryHeader.packet_len = entrySize;
+
+        std::vector<uint8_t> response;
+        response.reserve(sizeof(uint16_t) + 2 * entryCount);
+        response.push_back(static_cast<uint8_t>(entryCount));
+        response.push_back(static_cast<uint8_t>(entryCount >> 8));
+
+        std::vector<uint8_t> entry;
+        for (size_t i = 0; i < entryCount; i++)
+        {
+            const auto entryBegin = batch.packet.begin() + RnpHeader::size() + i * entrySize;
+
+            entry.clear();
+            entryHeader.serialize(entry);
+            entry.insert(entry.end(), entryBegin, entryBegin + entrySize);
+
+            packetptr_t entryptr = std::make_unique<RnpPacketSerialized>(entry);
+            const command_t cmd = CommandPacket::getCommand(*entryptr);
+
+            response.push_back(static_cast<uint8_t>(cmd));
+            response.push_back(static_cast<uint8_t>(executeCommand(cmd, entryptr)));
+        }
+
+        BinaryPacket &batchResponse = _pendingResponses.emplace_back(static_cast<uint8_t>(PACKET_TYPES::BATCH_RESPONSE), std::move(response));
+        batchResponse.header.source_service = batch.header.destination_service;
+        batchResponse.header.destination = batch.header.source;
+        batchResponse.header.destination_service = batch.header.source_service;
+        batchResponse.header.uid = batch.header.uid;
+    };
+
+    /**
+     * @brief Queue a command for the deferred worker, starting the worker if required
+     *
+     * @param packetptr
+     * @return true command queued
+     * @return false deferred queue full, command rejected
+     */
+    bool deferCommand(packetptr_t packetptr)
+    {
+        const command_t cmd = CommandPacket::getCommand(*packetptr);
+
+        if (_deferredQueue.size() >= _maxDeferredCommands)
+        {
+            queueStatus(cmd, *packetptr, COMMAND_STATUS::REJECTED, 0);
+            return false;
+        }
+
+        if (!_worker)
+        {
+            _worker = std::make_unique<RicCoreThread::Thread>([this](void *){ deferredWorker(); },
+                                                              nullptr,
+                                                              _workerStackSize,
+                                                              _workerPriority,
+                                                              _workerCoreID,
+                                                              "cmdworker");
+        }
+
+        queueStatus(cmd, *packetptr, COMMAND_STATUS::QUEUED, 0);
+        _deferredQueue.send(std::move(packetptr));
+        _deferredPending.give();
+        return true;
+    };
+
+    /**
+     * @brief Deferred worker loop, executes queued commands in order
+     *
+     */
+    void deferredWorker()
+    {
+        while (true)
+        {
+            // blocks until a command is queued or the worker is stopped
+            _deferredPending.take();
+            if (_stopWorker)
+            {
+                return;
+            }
+
+            packetptr_t packetptr = _deferredQueue.pop();
+            if (packetptr == nullptr)
+            {
+                continue;
+            }
+
+            const command_t cmd = CommandPacket::getCommand(*packetptr);
+            queueStatus(cmd, *packetptr, COMMAND_STATUS::STARTED, 0);
+            const uint32_t start = micros();
+            static_cast<DERIVED*>(this)->dispatchCommand(cmd, *packetptr);
+            queueStatus(cmd, *packetptr, COMMAND_STATUS::COMPLETED, micros() - start);
+        }
+    };
+
+    void queueStatus(command_t cmd, const RnpPacketSerialized &packet, COMMAND_STATUS status, uint32_t execution_time)
+    {
+        _statusQueue.send(std::make_unique<command_status_t>(command_status_t{cmd,
+                                                                              status,
+                                                                              execution_time,
+                                                                              packet.header.uid,
+                                                                              packet.header.source,
+                                                                              packet.header.source_service,
+                                                                              packet.header.destination_service}));
+    };
+
+    void sendStatus(const command_status_t &status)
+    {
+        std::vector<uint8_t> payload{static_cast<uint8_t>(status.command), static_cast<uint8_t>(status.status)};
+        for (size_t i = 0; i < sizeof(uint32_t); i++)
+        {
+            payload.push_back(static_cast<uint8_t>(status.execution_time >> (8 * i)));
+        }
+
+        BinaryPacket response(static_cast<uint8_t>(PACKET_TYPES::COMMAND_STATUS_RESPONSE), std::move(payload));
+        response.header.source_service = status.destination_service;
+        response.header.source = _sys.networkmanager.getAddress();
+        response.header.destination = status.source;
+        response.header.destination_service = status.source_service;
+        response.header.uid = status.uid;
+        _sys.networkmanager.sendPacket(response);
+    };
+
+    rate_limit_t *findRateLimit(command_t cmd)
+    {
+        for (size_t i = 0; i < _numRateLimits; i++)
+        {
+            if (_rateLimits[i].command == cmd)
+            {
+                return &_rateLimits[i];
+            }
+        }
+        return nullptr;
+    };
+
+    /**
+     * @brief Refill the token bucket of a rate limited command and take a token if one is available
+     *
+     * @param cmd
+     * @return true command allowed
+     * @return false command rate limited
+     */
+    bool consumeToken(command_t cmd)
+    {
+        rate_limit_t *limit = findRateLimit(cmd);
+        if (limit == nullptr)
+        {
+            return true;
+        }
+
+        const uint32_t now = millis();
+        if (limit->interval)
+        {
+            const uint32_t refills = (now - limit->last_refill) / limit->interval;
+            if (refills)
+            {
+                limit->tokens = static_cast<uint16_t>(std::min<uint32_t>(limit->capacity, limit->tokens + refills));
+                // keep the remainder of the elapsed time unless the bucket is full
+                limit->last_refill = (limit->tokens == limit->capacity) ? now : limit->last_refill + refills * limit->interval;
+            }
+        }
+
+        if (limit->tokens == 0)
+        {
+            return false;
+        }
+        --limit->tokens;
+        return true;
+    };
+
+    /**
+     * @brief Return a token taken by consumeToken to the bucket of a command which was not executed
+     *
+     * @param cmd
+     */
+    void refundToken(command_t cmd)
+    {
+        rate_limit_t *limit = findRateLimit(cmd);
+        if (limit != nullptr && limit->tokens < limit->capacity)
+        {
+            ++limit->tokens;
+        }
+    };
+
+    /**
+     * @brief Check if a packet with the same source and uid has been handled within the duplicate window,
+     * otherwise remember this packet
+     *
+     * @param header
+     * @return true packet is a replay
+     * @return false
+     */
+    bool isDuplicate(const RnpHeader &header)
+    {
+        if (!_duplicateWindow)
+        {
+            return false;
+        }
+
+        const uint32_t now = millis();
+        for (const duplicate_entry_t &entry : _duplicates)
+        {
+            if (entry.valid && entry.uid == header.uid && entry.source == header.source && (now - entry.time) < _duplicateWindow)
+            {
+                return true;
+            }
+        }
+
+        _duplicates[_duplicateHead] = duplicate_entry_t{now, header.uid, header.source, true};
+        _duplicateHead = (_duplicateHead + 1) % N_DUPLICATE_ENTRIES;
+        return false;
+    };
+
+    void recordRejection(uint8_t source, command_t cmd)
+    {
+        _lastRejectedSource = source;
+        _lastRejectedCommand = cmd;
+    };
+
+    /**
+     * @brief Log a summary of the commands rejected since the last summary, rate limited to one summary per
+     * REJECTION_LOG_INTERVAL
+     *
+     */
+    void logRejections()
+    {
+        const rejection_counts_t &counts = _rejectionCounts;
+        const rejection_counts_t &reported = _reportedRejectionCounts;
+
+        if (counts.disabled == reported.disabled &&
+            counts.rate_limited == reported.rate_limited &&
+            counts.duplicate == reported.duplicate &&
+            counts.queue_full == reported.queue_full)
+        {
+            return;
+        }
+
+        const uint32_t now = millis();
+        if (now - _lastRejectionLog < REJECTION_LOG_INTERVAL)
+        {
+            return;
+        }
+
+        RicCoreLogging::log<LOGGING_TARGET>("Rejected commands! Illegal: " + std::to_string(counts.disabled - reported.disabled) +
+                                            ", rate limited: " + std::to_string(counts.rate_limited - reported.rate_limited) +
+                                            ", duplicate packets: " + std::to_string(counts.duplicate - reported.duplicate) +
+                                            ", queue full: " + std::to_string(counts.queue_full - reported.queue_full) +
+                                            ", last source node: " + std::to_string(_lastRejectedSource) +
+                                            ", last command id: " + std::to_string(_lastRejectedCommand));
+
+        _reportedRejectionCounts = counts;
+        _lastRejectionLog = now;
+    };
+
+    void recordExecution(command_t cmd, uint32_t execution_time)
+    {
+        command_stats_t &stats = _commandStats[cmd];
+        ++stats.count;
+        stats.cumulative_time += execution_time;
+        if (execution_time > stats.max_time)
+        {
+            stats.max_time = execution_time;
+        }
+    };
+
+    /**
+     * @brief Simply a wrapper for handleCommand function for readability
+     *
+     * @param packetptr
+     */
+    void networkCallback(packetptr_t packetptr) override
+    {
+        handleCommand(std::move(packetptr));
+    };
+
+};
@@ -0,0 +1,129 @@
+#pragma once
+/**
+ * @file commandtable.h
+ * @brief Compile time command registration for the StaticCommandHandler. A command table is a list of
+ * (command id, command function) pairs given as types, e.g
+ *
+ *   using SystemCommands = CommandTable<Command<COMMAND_ID::LAUNCH, &Commands::LaunchCommand>,
+ *                                       CallableCommand<COMMAND_ID::ABORT, AbortCommand>>;
+ *
+ * Command functions are plain function pointers or default constructible callable types, so no closures are
+ * allocated and the handler can inline them into its dispatch.
+ */
+
+#include <cstddef>
+#include <array>
+#include <type_traits>
+
+#include <librnp/rnp_packet.h>
+
+/**
+ * @brief Command table entry calling a free function with the signature void(SYSTEM_T&, const RnpPacketSerialized&)
+ *
+ * @tparam ID command id, must be of the command id enum type of the handler
+ * @tparam FUNCTION pointer to the command function
+ */
+template <auto ID, auto FUNCTION>
+struct Command
+{
+    static_assert(std::is_enum_v<decltype(ID)>, "Command ID must be an enum!");
+
+    static constexpr auto id = ID;
+
+    template <typename SYSTEM_T>
+    static void invoke(SYSTEM_T &sys, const RnpPacketSerialized &packet)
+    {
+        FUNCTION(sys, packet);
+    };
+};
+
+/**
+ * @brief Command table entry calling a default constructible callable type, allows stateless lambdas to be
+ * registered through decltype.
+ *
+ * @tparam ID command id, must be of the command id enum type of the handler
+ * @tparam CALLABLE_T type with operator()(SYSTEM_T&, const RnpPacketSerialized&)
+ */
+template <auto ID, typename CALLABLE_T>
+struct CallableCommand
+{
+    static_assert(std::is_enum_v<decltype(ID)>, "Command ID must be an enum!");
+    static_assert(std::is_default_constructible_v<CALLABLE_T>, "Callable command type must be default constructible!");
+
+    static constexpr auto id = ID;
+
+    template <typename SYSTEM_T>
+    static void invoke(SYSTEM_T &sys, const RnpPacketSerialized &packet)
+    {
+        CALLABLE_T{}(sys, packet);
+    };
+};
+
+/**
+ * @brief Compile time list of commands
+ *
+ * @tparam COMMANDS Command or CallableCommand entries
+ */
+template <typename... COMMANDS>
+struct CommandTable
+{
+    static constexpr size_t size = sizeof...(COMMANDS);
+
+    /**
+     * @brief Check all command ids are of the given enum type
+     *
+     * @tparam COMMAND_ID_ENUM
+     */
+    template <typename COMMAND_ID_ENUM>
+    static constexpr bool idsOfType()
+    {
+        return (std::is_same_v<std::remove_cv_t<decltype(COMMANDS::id)>, COMMAND_ID_ENUM> && ...);
+    };
+
+    /**
+     * @brief Check all command ids are less than the given maximum
+     *
+     * @param maxCommands
+     */
+    static constexpr bool idsInRange(size_t maxCommands)
+    {
+        return ((static_cast<size_t>(COMMANDS::id) < maxCommands) && ...);
+    };
+
+    /**
+     * @brief Check no command id is registered more than once
+     *
+     */
+    static constexpr bool idsUnique()
+    {
+        constexpr std::array<size_t, size> ids{static_cast<size_t>(COMMANDS::id)...};
+        for (size_t i = 0; i < size; i++)
+        {
+            for (size_t j = i + 1; j < size; j++)
+            {
+                if (ids[i] == ids[j])
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    /**
+     * @brief Invoke the command registered to the given id. The fold expands to a chain of comparisons against
+     * compile time constants which the compiler lowers to a switch, with each command function inlined.
+     *
+     * @tparam SYSTEM_T
+     * @param cmd
+     * @param sys
+     * @param packet
+     * @return true command id found
+     * @return false no command registered to command id
+     */
+    template <typename SYSTEM_T>
+    static bool dispatch(size_t cmd, SYSTEM_T &sys, const RnpPacketSerialized &packet)
+    {
+        return ((cmd == static_cast<size_t>(COMMANDS::id) ? (COMMANDS::template invoke<SYSTEM_T>(sys, packet), true) : false) || ...);
+    };
+};
@@ -0,0 +1,79 @@
+#pragma once
+/**
+ * @file staticcommandhandler.h
+ * @brief Command handler with the command table fixed at compile time. Commands are registered through a
+ * CommandTable instead of a runtime map of std::function, so there is no heap allocation and dispatch compiles
+ * down to a switch over the command ids. Duplicate or out of range command ids fail to compile.
+ */
+
+#include <initializer_list>
+
+#include <librnp/rnp_packet.h>
+#include <librnp/default_packets/simplecommandpacket.h>
+
+#include "libriccore/util/bitsethelpers.h"
+#include <libriccore/riccorelogging.h>
+
+#include "commandhandlerbase.h"
+#include "commandtable.h"
+
+
+template <typename SYSTEM_T,
+          typename COMMAND_ID_ENUM,
+          typename COMMAND_TABLE,
+          size_t N_MAX_COMMANDS = 256,
+          RicCoreLoggingConfig::LOGGERS LOGGING_TARGET = RicCoreLoggingConfig::LOGGERS::SYS>
+class StaticCommandHandler : public CommandHandlerBase<StaticCommandHandler<SYSTEM_T,COMMAND_ID_ENUM,COMMAND_TABLE,N_MAX_COMMANDS,LOGGING_TARGET>,
+                                                       SYSTEM_T,COMMAND_ID_ENUM,N_MAX_COMMANDS,LOGGING_TARGET>
+{
+    static_assert(COMMAND_TABLE::template idsOfType<COMMAND_ID_ENUM>(), "Command table id type not the same as COMMAND_ID_ENUM template type!");
+    static_assert(COMMAND_TABLE::idsInRange(N_MAX_COMMANDS), "Command table contains a command id exceeding N_MAX_COMMANDS!");
+    static_assert(COMMAND_TABLE::idsUnique(), "Command table contains duplicate command ids!");
+
+    using base_t = CommandHandlerBase<StaticCommandHandler<SYSTEM_T,COMMAND_ID_ENUM,COMMAND_TABLE,N_MAX_COMMANDS,LOGGING_TARGET>,
+                                      SYSTEM_T,COMMAND_ID_ENUM,N_MAX_COMMANDS,LOGGING_TARGET>;
+    friend base_t;
+
+public:
+    using commandTable_t = COMMAND_TABLE;
+
+    /**
+     * @brief Static command handler constructor with default intialization for the default persistent enabled commands
+     *
+     * @param sys referece to the derived system object to allow commands to access system objects
+     * @param ServiceID network service ID
+     */
+    StaticCommandHandler(SYSTEM_T &sys,const uint8_t ServiceID) :
+                        base_t(sys,ServiceID,0){};
+
+    /**
+     * @brief Static command handler constructor with support for intializing the default persisnent enabled command bitset.
+     *
+     * @tparam T type of element of intializer list
+     * @param sys reference to the dervied system object
+     * @param ServiceID network service ID
+     * @param defaultPersistCommands intializer list of command ids to always be enabled during system lifetime
+     */
+    template <class T>
+    StaticCommandHandler(SYSTEM_T &sys,const uint8_t ServiceID,const std::initializer_list<T> defaultPersistCommands) :
+                        base_t(sys,ServiceID,RicCoreUtil::BitsetHelpers::generateBitset<N_MAX_COMMANDS>(defaultPersistCommands)){};
+
+    ~StaticCommandHandler()
+    {
+        this->stopDeferredWorker();
+    };
+
+private:
+    /**
+     * @brief Call the command function registered to an enabled command id, if any
+     *
+     * @param cmd
+     * @param packet
+     * @return true command function called
+     * @return false no command function registered
+     */
+    bool dispatchCommand(command_t cmd, const RnpPacketSerialized &packet)
+    {
+        return COMMAND_TABLE::dispatch(cmd, this->_sys, packet);
+    };
+};
@@ -0,0 +1,70 @@
+#pragma once
+/**
+ * @file exponentialmovingaverage.h
+ * @brief Exponential moving average, y = y + alpha * (x - y). The first sample initializes the output so there is no
+ * start up transient from 0.
+ */
+#include <cmath>
+#include <stdexcept>
+
+namespace RicCoreFiltering
+{
+    template <typename T = float>
+    class ExponentialMovingAverage
+    {
+    public:
+        /**
+         * @brief Construct a new Exponential Moving Average. Throws std::out_of_range if alpha is not in (0, 1].
+         *
+         * @param alpha smoothing factor, smaller is smoother
+         */
+        ExponentialMovingAverage(T alpha) : _alpha(alpha),
+                                            _output(0),
+                                            _initialized(false)
+        {
+            if (!(alpha > 0) || alpha > 1)
+            {
+                throw std::out_of_range("EMA alpha must be in (0, 1]!");
+            }
+        };
+
+        /**
+         * @brief Smoothing factor giving the same -3dB cutoff as a first order low pass filter
+         *
+         * @param cutoff cutoff frequency [Hz]
+         * @param sampleRate sample rate [Hz]
+         * @return T
+         */
+        static T alphaFromCutoff(T cutoff, T sampleRate)
+        {
+            const T rc = static_cast<T>(1) / (static_cast<T>(2 * M_PI) * cutoff);
+            const T dt = static_cast<T>(1) / sampleRate;
+            return dt / (rc + dt);
+        };
+
+        T update(T sample)
+        {
+            if (!_initialized)
+            {
+                _output = sample;
+                _initialized = true;
+                return _output;
+            }
+            _output += _alpha * (sample - _output);
+            return _output;
+        };
+
+        T get() const { return _output; };
+
+        void reset()
+        {
+            _output = 0;
+            _initialized = false;
+        };
+
+    private:
+        const T _alpha;
+        T _output;
+        bool _initialized;
+    };
+};
@@ -0,0 +1,375 @@
+#pragma once
+/**
+ * @file filterbank.h
+ * @brief Multi channel filter banks which filter one sample from each of N_CHANNELS channels per update. Filter state
+ * is stored as a structure of arrays, one contiguous array per state variable indexed by channel, so the per update
+ * loop runs across channels with no dependency between iterations. This lets the compiler vectorise it on x86 and
+ * keeps the esp32 fpu pipeline full, rather than each channel's filter being updated in turn through its own object.
+ * Blocks of samples are passed frame interleaved, i.e sample[frame * N_CHANNELS + channel], which is the layout a
+ * multi channel adc scan produces. A bank with N_CHANNELS = 1 also exposes the scalar update of the single channel
+ * filters so the same code can be used for single channels.
+ */
+#include <cstddef>
+#include <array>
+#include <algorithm>
+#include <type_traits>
+#include <stdexcept>
+
+#include <libriccore/filtering/iirfilter.h>
+
+namespace RicCoreFiltering
+{
+    /**
+     * @brief CRTP base of the filter banks, the derived bank only has to implement
+     * void updateFrame(const T* frame, T* output) filtering one sample of every channel. output is always the output
+     * frame of the bank so holds the previous output of each channel on entry. frame and output are declared
+     * __restrict and the state arrays are indexed as members rather than through pointers, so the compiler can prove
+     * the channel loop is free of aliasing and vectorise it without runtime checks.
+     *
+     * @tparam DERIVED
+     * @tparam T sample type
+     * @tparam N_CHANNELS
+     */
+    template <typename DERIVED, typename T, size_t N_CHANNELS>
+    class FilterBankBase
+    {
+        static_assert(N_CHANNELS > 0, "Filter bank must have at least one channel!");
+
+    public:
+        using frame_t = std::array<T, N_CHANNELS>;
+
+        /**
+         * @brief Filter one sample of every channel
+         *
+         * @param frame sample of each channel
+         * @return const frame_t& filter output of each channel
+         */
+        const frame_t &update(const frame_t &frame)
+        {
+            derived().updateFrame(frame.data(), _output.data());
+            return _output;
+        };
+
+        /**
+         * @brief Filter a block of frame interleaved samples
+         *
+         * @param input numFrames * N_CHANNELS samples, input[frame * N_CHANNELS + channel]
+         * @param output numFrames * N_CHANNELS filter outputs in the same layout, may alias input
+         * @param numFrames
+         */
+        void updateBlock(const T *input, T *output, size_t numFrames)
+        {
+            for (size_t frame = 0; frame < numFrames; frame++)
+            {
+                derived().updateFrame(input + frame * N_CHANNELS, _output.data());
+                std::copy(_output.begin(), _output.end(), output + frame * N_CHANNELS);
+            }
+        };
+
+        /**
+         * @brief Scalar update for single channel banks, matching the single channel filters
+         *
+         * @param sample
+         * @return T filter output
+         */
+        template <size_t C = N_CHANNELS, typename = std::enable_if_t<C == 1>>
+        T update(T sample)
+        {
+            derived().updateFrame(&sample, _output.data());
+            return _output[0];
+        };
+
+        /**
+         * @brief Latest filter output of every channel
+         *
+         * @return const frame_t&
+         */
+        const frame_t &get() const { return _output; };
+
+        /**
+         * @brief Latest filter output of a channel. Not bounds checked.
+         *
+         * @param channel
+         * @return T
+         */
+        T get(size_t channel) const { return _output[channel]; };
+
+        static constexpr size_t channels() { return N_CHANNELS; };
+
+    protected:
+        FilterBankBase() : _output(){};
+
+        frame_t _output;
+
+        static void checkChannel(size_t channel)
+        {
+            if (channel >= N_CHANNELS)
+            {
+                throw std::out_of_range("Filter bank channel out of range!");
+            }
+        };
+
+    private:
+        DERIVED &derived() { return static_cast<DERIVED &>(*this); };
+    };
+
+    /**
+     * @brief Moving average over the last N_WINDOW samples of each channel, see MovingAverage. The history is stored
+     * as N_WINDOW frames so the sample leaving the window of every channel is contiguous.
+     *
+     * @tparam N_CHANNELS
+     * @tparam N_WINDOW
+     * @tparam T floating point sample type
+     */
+    template <size_t N_CHANNELS, size_t N_WINDOW, typename T = float>
+    class MovingAverageBank : public FilterBankBase<MovingAverageBank<N_CHANNELS, N_WINDOW, T>, T, N_CHANNELS>
+    {
+        static_assert(std::is_floating_point_v<T>, "MovingAverageBank sample type must be floating point!");
+        static_assert(N_WINDOW > 0, "MovingAverageBank window must be non zero!");
+
+        using base_t = FilterBankBase<MovingAverageBank<N_CHANNELS, N_WINDOW, T>, T, N_CHANNELS>;
+        friend base_t;
+
+    public:
+        MovingAverageBank() : _history(),
+                              _sum(),
+                              _head(0),
+                              _size(0){};
+
+        /**
+         * @brief Number of samples in the window of each channel, less than N_WINDOW until the window fills
+         *
+         * @return size_t
+         */
+        size_t size() const { return _size; };
+
+        void reset()
+        {
+            _sum.fill(0);
+            this->_output.fill(0);
+            _head = 0;
+            _size = 0;
+        };
+
+    private:
+        std::array<std::array<T, N_CHANNELS>, N_WINDOW> _history;
+        std::array<T, N_CHANNELS> _sum;
+        size_t _head;
+        size_t _size;
+
+        void updateFrame(const T *__restrict frame, T *__restrict output)
+        {
+            std::array<T, N_CHANNELS> &oldest = _history[_head];
+
+            if (_size == N_WINDOW)
+            {
+                slide(_sum.data(), oldest.data(), frame);
+            }
+            else
+            {
+                ++_size;
+                accumulate(_sum.data(), frame);
+                std::copy(frame, frame + N_CHANNELS, oldest.begin());
+            }
+
+            const T scale = static_cast<T>(1) / static_cast<T>(_size);
+            for (size_t c = 0; c < N_CHANNELS; c++)
+            {
+                output[c] = _sum[c] * scale;
+            }
+
+            _head = (_head + 1 == N_WINDOW) ? 0 : _head + 1;
+            if (_head == 0)
+            {
+                resum();
+            }
+        };
+
+        /**
+         * @brief Recompute the running sums from the history, bounding rounding drift
+         *
+         */
+        void resum()
+        {
+            _sum.fill(0);
+            for (size_t i = 0; i < _size; i++)
+            {
+                accumulate(_sum.data(), _history[i].data());
+            }
+        };
+
+        // The history row is selected at runtime so the compiler can't tell it apart from _sum, the kernels below
+        // take __restrict pointers so the channel loops still vectorise.
+
+        static void accumulate(T *__restrict sum, const T *__restrict samples)
+        {
+            for (size_t c = 0; c < N_CHANNELS; c++)
+            {
+                sum[c] += samples[c];
+            }
+        };
+
+        static void slide(T *__restrict sum, T *__restrict oldest, const T *__restrict frame)
+        {
+            for (size_t c = 0; c < N_CHANNELS; c++)
+            {
+                sum[c] += frame[c] - oldest[c];
+                oldest[c] = frame[c];
+            }
+        };
+    };
+
+    /**
+     * @brief Exponential moving average of each channel, see ExponentialMovingAverage. The first frame initializes
+     * the output of every channel.
+     *
+     * @tparam N_CHANNELS
+     * @tparam T
+     */
+    template <size_t N_CHANNELS, typename T = float>
+    class ExponentialMovingAverageBank : public FilterBankBase<ExponentialMovingAverageBank<N_CHANNELS, T>, T, N_CHANNELS>
+    {
+        using base_t = FilterBankBase<ExponentialMovingAverageBank<N_CHANNELS, T>, T, N_CHANNELS>;
+        friend base_t;
+
+    public:
+        /**
+         * @brief Construct a new Exponential Moving Average Bank with the same smoothing factor on every channel.
+         * Throws std::out_of_range if alpha is not in (0, 1].
+         *
+         * @param alpha
+         */
+        ExponentialMovingAverageBank(T alpha) : _alpha(),
+                                                _initialized(false)
+        {
+            for (size_t c = 0; c < N_CHANNELS; c++)
+            {
+                setAlpha(c, alpha);
+            }
+        };
+
+        /**
+         * @brief Set the smoothing factor of a channel. Throws std::out_of_range if the channel is out of range or
+         * alpha is not in (0, 1].
+         *
+         * @param channel
+         * @param alpha
+         */
+        void setAlpha(size_t channel, T alpha)
+        {
+            base_t::checkChannel(channel);
+            if (!(alpha > 0) || alpha > 1)
+            {
+                throw std::out_of_range("EMA alpha must be in (0, 1]!");
+            }
+            _alpha[channel] = alpha;
+        };
+
+        void reset()
+        {
+            this->_output.fill(0);
+            _initialized = false;
+        };
+
+    private:
+        std::array<T, N_CHANNELS> _alpha;
+        bool _initialized;
+
+        void updateFrame(const T *__restrict frame, T *__restrict output)
+        {
+            if (!_initialized)
+            {
+                std::copy(frame, frame + N_CHANNELS, output);
+                _initialized = true;
+                return;
+            }
+
+            for (size_t c = 0; c < N_CHANNELS; c++)
+            {
+                output[c] += _alpha[c] * (frame[c] - output[c]);
+            }
+        };
+    };
+
+    /**
+     * @brief Biquad of each channel in direct form II transposed, see Biquad. Channels can have different
+     * coefficients.
+     *
+     * @tparam N_CHANNELS
+     * @tparam T
+     */
+    template <size_t N_CHANNELS, typename T = float>
+    class BiquadBank : public FilterBankBase<BiquadBank<N_CHANNELS, T>, T, N_CHANNELS>
+    {
+        using base_t = FilterBankBase<BiquadBank<N_CHANNELS, T>, T, N_CHANNELS>;
+        friend base_t;
+
+    public:
+        /**
+         * @brief Construct a new Biquad Bank with the coefficients of a prototype filter on every channel, e.g
+         * BiquadBank<8>(Biquad<>::lowPass(10, 1000))
+         *
+         * @param prototype
+         */
+        BiquadBank(const Biquad<T> &prototype) : _b0(),
+                                                 _b1(),
+                                                 _b2(),
+                                                 _a1(),
+                                                 _a2(),
+                                                 _z1(),
+                                                 _z2()
+        {
+            for (size_t c = 0; c < N_CHANNELS; c++)
+            {
+                setCoefficients(c, prototype);
+            }
+        };
+
+        /**
+         * @brief Set the coefficients of a channel from a prototype filter, the channel state is not reset. Throws
+         * std::out_of_range if the channel is out of range.
+         *
+         * @param channel
+         * @param prototype
+         */
+        void setCoefficients(size_t channel, const Biquad<T> &prototype)
+        {
+            base_t::checkChannel(channel);
+            const typename Biquad<T>::coefficients_t coefficients = prototype.getCoefficients();
+            _b0[channel] = coefficients.b0;
+            _b1[channel] = coefficients.b1;
+            _b2[channel] = coefficients.b2;
+            _a1[channel] = coefficients.a1;
+            _a2[channel] = coefficients.a2;
+        };
+
+        void reset()
+        {
+            _z1.fill(0);
+            _z2.fill(0);
+            this->_output.fill(0);
+        };
+
+    private:
+        std::array<T, N_CHANNELS> _b0;
+        std::array<T, N_CHANNELS> _b1;
+        std::array<T, N_CHANNELS> _b2;
+        std::array<T, N_CHANNELS> _a1;
+        std::array<T, N_CHANNELS> _a2;
+
+        std::array<T, N_CHANNELS> _z1;
+        std::array<T, N_CHANNELS> _z2;
+
+        void updateFrame(const T *__restrict frame, T *__restrict output)
+        {
+            for (size_t c = 0; c < N_CHANNELS; c++)
+            {
+                const T x = frame[c];
+                const T y = _b0[c] * x + _z1[c];
+                _z1[c] = _b1[c] * x - _a1[c] * y + _z2[c];
+                _z2[c] = _b2[c] * x - _a2[c] * y;
+                output[c] = y;
+            }
+        };
+    };
+};
@@ -0,0 +1,192 @@
+#pragma once
+/**
+ * @file iirfilter.h
+ * @brief First and second order (biquad) IIR filters. Coefficients are normalized so a0 = 1, and the design helpers
+ * use the bilinear transform with the cutoff prewarped so the -3dB point lands at the requested frequency. The biquad
+ * uses direct form II transposed, which needs only two state variables and behaves well with floating point. Higher
+ * order filters can be built by cascading biquads.
+ */
+#include <cmath>
+#include <stdexcept>
+
+namespace RicCoreFiltering
+{
+    /**
+     * @brief First order IIR filter, y[n] = b0 x[n] + b1 x[n-1] - a1 y[n-1]
+     *
+     * @tparam T
+     */
+    template <typename T = float>
+    class FirstOrderIIR
+    {
+    public:
+        FirstOrderIIR(T b0, T b1, T a1) : _b0(b0),
+                                          _b1(b1),
+                                          _a1(a1),
+                                          _x1(0),
+                                          _y1(0){};
+
+        /**
+         * @brief First order low pass filter. Throws std::out_of_range if the cutoff is not below the nyquist
+         * frequency.
+         *
+         * @param cutoff -3dB frequency [Hz]
+         * @param sampleRate sample rate [Hz]
+         * @return FirstOrderIIR
+         */
+        static FirstOrderIIR lowPass(T cutoff, T sampleRate)
+        {
+            const T k = prewarp(cutoff, sampleRate);
+            const T norm = static_cast<T>(1) / (k + 1);
+            return FirstOrderIIR(k * norm, k * norm, (k - 1) * norm);
+        };
+
+        /**
+         * @brief First order high pass filter. Throws std::out_of_range if the cutoff is not below the nyquist
+         * frequency.
+         *
+         * @param cutoff -3dB frequency [Hz]
+         * @param sampleRate sample rate [Hz]
+         * @return FirstOrderIIR
+         */
+        static FirstOrderIIR highPass(T cutoff, T sampleRate)
+        {
+            const T k = prewarp(cutoff, sampleRate);
+            const T norm = static_cast<T>(1) / (k + 1);
+            return FirstOrderIIR(norm, -norm, (k - 1) * norm);
+        };
+
+        T update(T sample)
+        {
+            _y1 = _b0 * sample + _b1 * _x1 - _a1 * _y1;
+            _x1 = sample;
+            return _y1;
+        };
+
+        T get() const { return _y1; };
+
+        void reset()
+        {
+            _x1 = 0;
+            _y1 = 0;
+        };
+
+    private:
+        T _b0;
+        T _b1;
+        T _a1;
+
+        T _x1;
+        T _y1;
+
+        static T prewarp(T cutoff, T sampleRate)
+        {
+            if (!(cutoff > 0) || !(cutoff < sampleRate / 2))
+            {
+                throw std::out_of_range("IIR cutoff must be between 0 and the nyquist frequency!");
+            }
+            return std::tan(static_cast<T>(M_PI) * cutoff / sampleRate);
+        };
+    };
+
+    /**
+     * @brief Second order IIR filter in direct form II transposed,
+     * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+     *
+     * @tparam T
+     */
+    template <typename T = float>
+    class Biquad
+    {
+    public:
+        struct coefficients_t
+        {
+            T b0;
+            T b1;
+            T b2;
+            T a1;
+            T a2;
+        };
+
+        Biquad(T b0, T b1, T b2, T a1, T a2) : _b0(b0),
+                                               _b1(b1),
+                                               _b2(b2),
+                                               _a1(a1),
+                                               _a2(a2),
+                                               _z1(0),
+                                               _z2(0),
+                                               _output(0){};
+
+        /**
+         * @brief Second order low pass filter. Throws std::out_of_range if the cutoff is not below the nyquist
+         * frequency.
+         *
+         * @param cutoff -3dB frequency when Q = 1/sqrt(2) [Hz]
+         * @param sampleRate sample rate [Hz]
+         * @param Q quality factor, default gives a butterworth response
+         * @return Biquad
+         */
+        static Biquad lowPass(T cutoff, T sampleRate, T Q = static_cast<T>(M_SQRT1_2))
+        {
+            const T k = prewarp(cutoff, sampleRate);
+            const T norm = static_cast<T>(1) / (1 + k / Q + k * k);
+            const T b0 = k * k * norm;
+            return Biquad(b0, 2 * b0, b0, 2 * (k * k - 1) * norm, (1 - k / Q + k * k) * norm);
+        };
+
+        /**
+         * @brief Second order high pass filter. Throws std::out_of_range if the cutoff is not below the nyquist
+         * frequency.
+         *
+         * @param cutoff -3dB frequency when Q = 1/sqrt(2) [Hz]
+         * @param sampleRate sample rate [Hz]
+         * @param Q quality factor, default gives a butterworth response
+         * @return Biquad
+         */
+        static Biquad highPass(T cutoff, T sampleRate, T Q = static_cast<T>(M_SQRT1_2))
+        {
+            const T k = prewarp(cutoff, sampleRate);
+            const T norm = static_cast<T>(1) / (1 + k / Q + k * k);
+            return Biquad(norm, -2 * norm, norm, 2 * (k * k - 1) * norm, (1 - k / Q + k * k) * norm);
+        };
+
+        T update(T sample)
+        {
+            _output = _b0 * sample + _z1;
+            _z1 = _b1 * sample - _a1 * _output + _z2;
+            _z2 = _b2 * sample - _a2 * _output;
+            return _output;
+        };
+
+        T get() const { return _output; };
+
+        coefficients_t getCoefficients() const { return {_b0, _b1, _b2, _a1, _a2}; };
+
+        void reset()
+        {
+            _z1 = 0;
+            _z2 = 0;
+            _output = 0;
+        };
+
+    private:
+        T _b0;
+        T _b1;
+        T _b2;
+        T _a1;
+        T _a2;
+
+        T _z1;
+        T _z2;
+        T _output;
+
+        static T prewarp(T cutoff, T sampleRate)
+        {
+            if (!(cutoff > 0) || !(cutoff < sampleRate / 2))
+            {
+                throw std::out_of_range("IIR cutoff must be between 0 and the nyquist frequency!");
+            }
+            return std::tan(static_cast<T>(M_PI) * cutoff / sampleRate);
+        };
+    };
+};
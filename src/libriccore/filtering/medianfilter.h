@@ -0,0 +1,92 @@
+#pragma once
+/**
+ * @file medianfilter.h
+ * @brief Heap free running median of the last N samples, useful to reject single sample spikes. The window is kept
+ * sorted alongside the circular buffer so each update removes the oldest sample and inserts the new one in O(N) with
+ * no sorting, intended for small windows (e.g 3 to 15). Until the window fills the median is over the samples
+ * received so far, with an even number of samples the mean of the two middle samples is returned.
+ * NaN samples are rejected and the previous median returned, as a NaN can't be ordered in the window.
+ */
+#include <cstddef>
+#include <array>
+#include <cmath>
+#include <type_traits>
+
+#include <libriccore/util/circularbuffer.h>
+
+namespace RicCoreFiltering
+{
+    template <typename T, size_t N>
+    class MedianFilter
+    {
+    public:
+        MedianFilter() : _samples(),
+                         _sorted(),
+                         _median(0){};
+
+        T update(T sample)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                if (std::isnan(sample))
+                {
+                    return _median;
+                }
+            }
+
+            size_t size = _samples.size();
+
+            if (_samples.full())
+            {
+                // remove the oldest sample from the sorted window
+                const T oldest = _samples.oldest();
+                size_t index = 0;
+                while (index + 1 < size && _sorted[index] != oldest)
+                {
+                    ++index;
+                }
+                for (; index + 1 < size; index++)
+                {
+                    _sorted[index] = _sorted[index + 1];
+                }
+                --size;
+            }
+            _samples.push(sample);
+
+            // insert the new sample, shifting larger samples up
+            size_t index = size;
+            while (index > 0 && sample < _sorted[index - 1])
+            {
+                _sorted[index] = _sorted[index - 1];
+                --index;
+            }
+            _sorted[index] = sample;
+            ++size;
+
+            const size_t middle = size / 2;
+            _median = (size % 2) ? _sorted[middle] : static_cast<T>((_sorted[middle - 1] + _sorted[middle]) / 2);
+            return _median;
+        };
+
+        T get() const { return _median; };
+
+        size_t size() const { return _samples.size(); };
+
+        void reset()
+        {
+            _samples.clear();
+            _median = 0;
+        };
+
+    private:
+        RicCoreUtil::CircularBuffer<T, N> _samples;
+
+        /**
+         * @brief The samples in the window in ascending order
+         *
+         */
+        std::array<T, N> _sorted;
+
+        T _median;
+    };
+};
@@ -1,5 +1,8 @@
 #pragma once
+// Deprecated, sums the whole window every update and allocates per sample. Use RicCoreFiltering::MovingAverage
+// from <libriccore/filtering/movingaverage.h> instead.
 #include <stdint.h>
+#include <deque>
 
 class MovingAvg{
 
@@ -0,0 +1,96 @@
+#pragma once
+/**
+ * @file movingaverage.h
+ * @brief Heap free moving average over the last N samples. A running sum is kept alongside a circular buffer so
+ * update is O(1) regardless of the window size, and until the window fills the average is over the samples received
+ * so far. Floating point running sums are recomputed from the buffer once every N samples, bounding rounding drift at
+ * an amortized O(1) cost. Replaces MovingAvg.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <libriccore/util/circularbuffer.h>
+
+namespace RicCoreFiltering
+{
+    /**
+     * @brief Moving average filter
+     *
+     * @tparam T sample type
+     * @tparam N window size
+     * @tparam ACC_T running sum type, must be wide enough to hold the sum of N samples
+     */
+    template <typename T,
+              size_t N,
+              typename ACC_T = std::conditional_t<std::is_floating_point_v<T>, T, int64_t>>
+    class MovingAverage
+    {
+    public:
+        MovingAverage() : _samples(),
+                          _sum(0),
+                          _avg(0){};
+
+        /**
+         * @brief Add a new sample
+         *
+         * @param sample
+         * @return T average of the window
+         */
+        T update(T sample)
+        {
+            if (_samples.full())
+            {
+                _sum -= static_cast<ACC_T>(_samples.oldest());
+            }
+            _samples.push(sample);
+            _sum += static_cast<ACC_T>(sample);
+
+            if constexpr (std::is_floating_point_v<ACC_T>)
+            {
+                if (_samples.head() == 0)
+                {
+                    resum();
+                }
+            }
+
+            _avg = static_cast<T>(_sum / static_cast<ACC_T>(_samples.size()));
+            return _avg;
+        };
+
+        /**
+         * @brief Current average, 0 before any sample has been added
+         *
+         * @return T
+         */
+        T get() const { return _avg; };
+
+        /**
+         * @brief Number of samples in the window, less than N until the window fills
+         *
+         * @return size_t
+         */
+        size_t size() const { return _samples.size(); };
+
+        void reset()
+        {
+            _samples.clear();
+            _sum = 0;
+            _avg = 0;
+        };
+
+    private:
+        RicCoreUtil::CircularBuffer<T, N> _samples;
+        ACC_T _sum;
+        T _avg;
+
+        void resum()
+        {
+            _sum = 0;
+            for (size_t i = 0; i < _samples.size(); i++)
+            {
+                _sum += static_cast<ACC_T>(_samples[i]);
+            }
+        };
+    };
+};
@@ -0,0 +1,110 @@
+#pragma once
+/**
+ * @file orthogonalstate.h
+ * @brief Orthogonal (parallel) state. Holds a number of independent regions, each with its own nested statemachine,
+ * which are all updated within a single update of the owning statemachine. This allows independent subsystems to share
+ * one statemachine and update schedule. Regions are entered in order after the orthogonal state is entered, and exited in
+ * reverse order before the orthogonal state is exited.
+ */
+#include <memory>
+#include <vector>
+
+#include "state.h"
+#include "statemachine.h"
+
+template <typename SYSTEM_FLAGS_T>
+class OrthogonalState : public State<SYSTEM_FLAGS_T>
+{
+public:
+  OrthogonalState(SYSTEM_FLAGS_T ID, SystemStatus<SYSTEM_FLAGS_T> &systemstatus) : State<SYSTEM_FLAGS_T>(ID, systemstatus){};
+
+  /**
+   * @brief Enter the orthogonal state, then enter the initial state of each region
+   *
+   */
+  void initialize() override
+  {
+    State<SYSTEM_FLAGS_T>::initialize();
+
+    std::vector<std::unique_ptr<State<SYSTEM_FLAGS_T>>> initialStates = initialRegionStates();
+    regions = std::vector<StateMachine<SYSTEM_FLAGS_T>>(initialStates.size());
+
+    for (size_t i = 0; i < initialStates.size(); i++)
+    {
+      regions[i].initalize(std::move(initialStates[i]));
+    }
+  };
+
+  /**
+   * @brief Runs the parent update, if this returns a new state all regions are pre-empted and the new state is
+   * returned to the owning statemachine, otherwise every region is updated in order.
+   *
+   * @return std::unique_ptr<State<SYSTEM_FLAGS_T>>
+   */
+  std::unique_ptr<State<SYSTEM_FLAGS_T>> update() final
+  {
+    std::unique_ptr<State<SYSTEM_FLAGS_T>> preemptState = parentUpdate();
+
+    if (preemptState)
+    {
+      return preemptState;
+    }
+
+    for (StateMachine<SYSTEM_FLAGS_T> &region : regions)
+    {
+      region.update();
+    }
+    return nullptr;
+  };
+
+  /**
+   * @brief Exit every region in reverse order, then exit the orthogonal state
+   *
+   */
+  void exit() override
+  {
+    for (auto it = regions.rbegin(); it != regions.rend(); ++it)
+    {
+      it->exit();
+    }
+    regions.clear();
+
+    State<SYSTEM_FLAGS_T>::exit();
+  };
+
+  /**
+   * @brief Returns the id of the active state in the given region
+   *
+   * @param region index of region
+   * @return SYSTEM_FLAGS_T
+   */
+  SYSTEM_FLAGS_T getRegionStateID(size_t region)
+  {
+    return regions.at(region).getCurrentStateID();
+  };
+
+protected:
+  /**
+   * @brief Returns the initial state of each region, one region is created per returned state
+   *
+   * @return std::vector<std::unique_ptr<State<SYSTEM_FLAGS_T>>>
+   */
+  virtual std::vector<std::unique_ptr<State<SYSTEM_FLAGS_T>>> initialRegionStates() = 0;
+
+  /**
+   * @brief Behaviour shared across all regions, called before the regions are updated. Return nullptr to
+   * continue updating the regions, otherwise return the state to transition the owning statemachine to.
+   *
+   * @return std::unique_ptr<State<SYSTEM_FLAGS_T>>
+   */
+  virtual std::unique_ptr<State<SYSTEM_FLAGS_T>> parentUpdate()
+  {
+    return nullptr;
+  };
+
+  /**
+   * @brief Nested statemachines for each region
+   *
+   */
+  std::vector<StateMachine<SYSTEM_FLAGS_T>> regions;
+};
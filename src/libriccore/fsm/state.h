@@ -41,7 +41,7 @@ public:
    */
   virtual void initialize()
   {
-    time_entered_state = millis();
+    time_entered_state = micros64() / 1000;
     _systemstatus.newFlag(stateID, "state entered");
   };
 
@@ -57,14 +57,15 @@ public:
   };
 
   /**
-   * @brief Exit state transition, records exit and duration time
+   * @brief Exit state transition, records exit and duration time. The duration is not logged to avoid
+   * allocating on every transition, attach a StateTrace to the statemachine to record it.
    *
    */
   virtual void exit()
   {
-    time_exited_state = millis();
+    time_exited_state = micros64() / 1000;
     time_duration_state = time_exited_state - time_entered_state;
-    _systemstatus.deleteFlag(stateID, "state exited | state duration: " + std::to_string(time_duration_state));
+    _systemstatus.deleteFlag(stateID, "state exited");
   };
 
   /**
@@ -80,6 +81,7 @@ public:
 protected:
   const SYSTEM_FLAGS_T stateID;
 
+  // monotonic state entry and exit times [ms], derived from micros64() so they never wrap
   uint64_t time_entered_state;
   uint64_t time_exited_state;
   uint64_t time_duration_state;
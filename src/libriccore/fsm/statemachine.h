@@ -13,8 +13,12 @@
 
 #include <memory>
 #include <cstdint>
+#include <vector>
+
+#include <libriccore/platform/millis.h>
 
 #include "state.h"
+#include "statemonitor.h"
 
 template <typename SYSTEM_FLAG_T>
 class StateMachine
@@ -46,7 +50,24 @@ public:
    */
   void update()
   {
-    std::unique_ptr<State<SYSTEM_FLAG_T>> returnedState = currState->update();
+    std::unique_ptr<State<SYSTEM_FLAG_T>> returnedState;
+
+    if (monitors.empty())
+    {
+      returnedState = currState->update();
+    }
+    else
+    {
+      const uint32_t updateStart = micros();
+      returnedState = currState->update();
+      const uint32_t executionTime = micros() - updateStart;
+
+      for (StateMonitor<SYSTEM_FLAG_T> *monitor : monitors)
+      {
+        monitor->onUpdate(currState->getID(), executionTime);
+      }
+    }
+    ++updateCount;
 
     if (returnedState)
     {
@@ -63,12 +84,67 @@ public:
 
   void changeState(std::unique_ptr<State<SYSTEM_FLAG_T>> newState)
   {
+    SYSTEM_FLAG_T previousStateID = static_cast<SYSTEM_FLAG_T>(0);
+    const bool hadState = static_cast<bool>(currState);
     if (currState)
     { // call exit only if currState is not null
       currState->exit();
+      previousStateID = currState->getID();
     }
     currState = std::move(newState);
     currState->initialize();
+
+    const uint32_t previousUpdateCount = updateCount;
+    updateCount = 0;
+
+    // always record the entry time so a monitor attached later doesn't measure its first dwell from a stale time
+    const uint32_t now = millis();
+    const uint32_t dwellTime = now - timeEnteredState;
+    timeEnteredState = now;
+
+    for (StateMonitor<SYSTEM_FLAG_T> *monitor : monitors)
+    {
+      if (!hadState)
+      {
+        monitor->onInitialState(currState->getID());
+        continue;
+      }
+      monitor->onTransition(previousStateID, currState->getID(), dwellTime, previousUpdateCount);
+    }
+  };
+
+  /**
+   * @brief Attach a monitor (e.g. StateTrace) which is notified of every transition and update. The monitor must
+   * outlive the statemachine. When no monitors are attached, update is not timed.
+   *
+   * @param monitor
+   */
+  void addMonitor(StateMonitor<SYSTEM_FLAG_T> &monitor)
+  {
+    monitors.push_back(&monitor);
+  };
+
+  /**
+   * @brief Exit the current state and leave the statemachine without an active state. Used by composite states
+   * to exit their substates before exiting themselves.
+   *
+   */
+  void exit()
+  {
+    if (currState)
+    {
+      currState->exit();
+      currState.reset();
+    }
+  };
+
+  /**
+   * @brief Returns true if the statemachine has an active state
+   *
+   */
+  bool active() const
+  {
+    return static_cast<bool>(currState);
   };
 
   SYSTEM_FLAG_T getCurrentStateID()
@@ -78,4 +154,18 @@ public:
 
 private:
   std::unique_ptr<State<SYSTEM_FLAG_T>> currState;
+
+  std::vector<StateMonitor<SYSTEM_FLAG_T> *> monitors;
+
+  /**
+   * @brief Time the current state was entered [ms]
+   *
+   */
+  uint32_t timeEnteredState = 0;
+
+  /**
+   * @brief Number of updates of the current state
+   *
+   */
+  uint32_t updateCount = 0;
 };
@@ -0,0 +1,97 @@
+#pragma once
+/**
+ * @file statemonitor.h
+ * @brief Abstract interface for instrumentation attached to a statemachine. Monitors are notified of every
+ * transition and every state update so tracing and profiling can be added without modifying the states themselves.
+ * Implementations are called from the statemachine update so must not allocate or block.
+ * State ids are system flags, so monitors which index or serialize states use the position of the state flag bit
+ * (stateIndex) rather than the flag value, which keeps states of any flag width in a fixed uint16. For a wide flag
+ * enum (WideFlags specialized) the enum values are already bit indices, so the index is the enum value.
+ */
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#include <libriccore/systemstatus/widebitwiseflagmanager.h>
+
+template <typename SYSTEM_FLAGS_T>
+class StateMonitor
+{
+public:
+  /**
+   * @brief Called after a transition has completed
+   *
+   * @param from id of the exited state
+   * @param to id of the entered state
+   * @param dwell time spent in the exited state [ms]
+   * @param update_count number of times the exited state was updated
+   */
+  virtual void onTransition(SYSTEM_FLAGS_T from, SYSTEM_FLAGS_T to, uint32_t dwell, uint32_t update_count) = 0;
+
+  /**
+   * @brief Called instead of onTransition when a state is entered with no previous state, as a zero from id is a
+   * valid state of a wide flag enum. Defaults to onTransition with a zero from id.
+   *
+   * @param to id of the entered state
+   */
+  virtual void onInitialState(SYSTEM_FLAGS_T to)
+  {
+    onTransition(static_cast<SYSTEM_FLAGS_T>(0), to, 0, 0);
+  };
+
+  /**
+   * @brief Called after each state update
+   *
+   * @param state id of the updated state
+   * @param execution_time execution time of the state update [us]
+   */
+  virtual void onUpdate(SYSTEM_FLAGS_T state, uint32_t execution_time) = 0;
+
+  virtual ~StateMonitor(){};
+
+  using stateIndex_t = uint16_t;
+
+  /**
+   * @brief State index used for no state, e.g the exited state of the first transition
+   *
+   */
+  static constexpr stateIndex_t NO_STATE = UINT16_MAX;
+
+  /**
+   * @brief Whether the system flags are a wide flag enum of bit indices rather than bit masks
+   *
+   */
+  static constexpr bool WIDE_FLAGS = WideFlags<SYSTEM_FLAGS_T>::value != 0;
+
+  /**
+   * @brief Number of distinct state indices, one per bit of the system flags, or the number of wide flags
+   *
+   */
+  static constexpr size_t N_STATES = WIDE_FLAGS ? WideFlags<SYSTEM_FLAGS_T>::value : sizeof(std::underlying_type_t<SYSTEM_FLAGS_T>) * 8;
+
+  static_assert(N_STATES < NO_STATE, "Too many states to index!");
+
+  /**
+   * @brief Index of a state, the position of its flag bit or the enum value of a wide flag enum
+   *
+   * @param state
+   * @return stateIndex_t
+   */
+  static stateIndex_t stateIndex(SYSTEM_FLAGS_T state)
+  {
+    auto value = static_cast<std::underlying_type_t<SYSTEM_FLAGS_T>>(state);
+    if constexpr (WIDE_FLAGS)
+    {
+      return static_cast<stateIndex_t>(value);
+    }
+    else
+    {
+      stateIndex_t index = 0;
+      while (value >>= 1)
+      {
+        ++index;
+      }
+      return index;
+    }
+  };
+};
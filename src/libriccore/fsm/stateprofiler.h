@@ -0,0 +1,245 @@
+#pragma once
+/**
+ * @file stateprofiler.h
+ * @brief Optional statemachine instrumentation recording the execution time of every state update. Min, mean, max
+ * and p99 update durations are kept per state id in fixed memory, and a per state time budget can be set. If a state
+ * update exceeds its budget, the overrun is counted and the configured overrun flag is raised in the system status.
+ * The flag is latched until clearOverrunFlag is called so a single overrun isn't missed. Attach to a statemachine with
+ * addMonitor.
+ */
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <optional>
+#include <vector>
+#include <type_traits>
+
+#include <libriccore/systemstatus/systemstatus.h>
+#include <libriccore/util/durationstats.h>
+
+#include "statemonitor.h"
+
+template <typename SYSTEM_FLAGS_T, size_t N_PROFILED_STATES = 16>
+class StateProfiler : public StateMonitor<SYSTEM_FLAGS_T>
+{
+    using T_underlying = std::underlying_type_t<SYSTEM_FLAGS_T>;
+
+public:
+    /**
+     * @brief Construct a new State Profiler
+     *
+     * @param systemstatus
+     * @param overrunFlag flag raised when a state update exceeds its budget
+     */
+    StateProfiler(SystemStatus<SYSTEM_FLAGS_T> &systemstatus, SYSTEM_FLAGS_T overrunFlag) : _systemstatus(systemstatus),
+                                                                                            _overrunFlag(overrunFlag),
+                                                                                            _profiles(),
+                                                                                            _numProfiles(0),
+                                                                                            _lastProfile(0){};
+
+    /**
+     * @brief Set the update budget for a given state, 0 disables the budget. Returns false if the maximum number
+     * of profiled states has been reached.
+     *
+     * @param state
+     * @param budget maximum update execution time [us]
+     * @return true
+     * @return false
+     */
+    bool setBudget(SYSTEM_FLAGS_T state, uint32_t budget)
+    {
+        profile_t *profile = getProfile(state);
+        if (profile == nullptr)
+        {
+            return false;
+        }
+        profile->budget = budget;
+        return true;
+    };
+
+    void onTransition(SYSTEM_FLAGS_T from, SYSTEM_FLAGS_T to, uint32_t dwell, uint32_t update_count) override{};
+
+    void onUpdate(SYSTEM_FLAGS_T state, uint32_t execution_time) override
+    {
+        profile_t *profile = getProfile(state);
+        if (profile == nullptr)
+        {
+            // no space left to profile this state
+            return;
+        }
+
+        profile->stats.record(execution_time);
+
+        if (profile->budget && (execution_time > profile->budget))
+        {
+            ++profile->overruns;
+            _systemstatus.newFlag(_overrunFlag, "state update overran budget");
+        }
+    };
+
+    /**
+     * @brief Get the update statistics of a state, returns nullptr if the state has not been profiled
+     *
+     * @param state
+     * @return const RicCoreUtil::DurationStats*
+     */
+    const RicCoreUtil::DurationStats *getStats(SYSTEM_FLAGS_T state) const
+    {
+        const profile_t *profile = findProfile(state);
+        return profile ? &profile->stats : nullptr;
+    };
+
+    /**
+     * @brief Get the number of budget overruns of a state
+     *
+     * @param state
+     * @return uint32_t
+     */
+    uint32_t getOverruns(SYSTEM_FLAGS_T state) const
+    {
+        const profile_t *profile = findProfile(state);
+        return profile ? profile->overruns : 0;
+    };
+
+    /**
+     * @brief Returns the profiled state with the largest maximum update time, useful to find which state is
+     * blowing the main loop period. Empty if nothing has been profiled, as a zero flag is a valid state of a wide flag enum.
+     *
+     * @return std::optional<SYSTEM_FLAGS_T>
+     */
+    std::optional<SYSTEM_FLAGS_T> getWorstState() const
+    {
+        std::optional<SYSTEM_FLAGS_T> worst;
+        uint32_t worstTime = 0;
+        for (size_t i = 0; i < _numProfiles; i++)
+        {
+            if (_profiles[i].stats.count() && _profiles[i].stats.max() >= worstTime)
+            {
+                worstTime = _profiles[i].stats.max();
+                worst = _profiles[i].state;
+            }
+        }
+        return worst;
+    };
+
+    /**
+     * @brief Serializes a summary of every profiled state.
+     * Format: uint32 state count, {uint16 state index, uint32 budget, uint32 overruns, DurationStats::summary_t}[count]
+     * where the state index is the position of the state flag bit or the wide flag value, as in StateTrace
+     *
+     * @param buf buffer to append to
+     */
+    void serialize(std::vector<uint8_t> &buf) const
+    {
+        appendBytes(buf, static_cast<uint32_t>(_numProfiles));
+        for (size_t i = 0; i < _numProfiles; i++)
+        {
+            const profile_t &profile = _profiles[i];
+            appendBytes(buf, StateMonitor<SYSTEM_FLAGS_T>::stateIndex(profile.state));
+            appendBytes(buf, profile.budget);
+            appendBytes(buf, profile.overruns);
+            appendBytes(buf, profile.stats.summary());
+        }
+    };
+
+    /**
+     * @brief Clear the overrun flag in the system status
+     *
+     */
+    void clearOverrunFlag()
+    {
+        _systemstatus.deleteFlag(_overrunFlag, "state overrun cleared");
+    };
+
+    /**
+     * @brief Reset all statistics and overrun counts, budgets are kept
+     *
+     */
+    void resetStats()
+    {
+        for (size_t i = 0; i < _numProfiles; i++)
+        {
+            _profiles[i].stats.reset();
+            _profiles[i].overruns = 0;
+        }
+    };
+
+private:
+    struct profile_t
+    {
+        SYSTEM_FLAGS_T state;
+        uint32_t budget;
+        uint32_t overruns;
+        RicCoreUtil::DurationStats stats;
+    };
+
+    SystemStatus<SYSTEM_FLAGS_T> &_systemstatus;
+
+    const SYSTEM_FLAGS_T _overrunFlag;
+
+    std::array<profile_t, N_PROFILED_STATES> _profiles;
+    size_t _numProfiles;
+
+    /**
+     * @brief Index of the last profile accessed, as the same state is normally updated many times in a row
+     * this avoids searching the profiles
+     *
+     */
+    size_t _lastProfile;
+
+    const profile_t *findProfile(SYSTEM_FLAGS_T state) const
+    {
+        for (size_t i = 0; i < _numProfiles; i++)
+        {
+            if (_profiles[i].state == state)
+            {
+                return &_profiles[i];
+            }
+        }
+        return nullptr;
+    };
+
+    /**
+     * @brief Find the profile of the given state, creating one if it doesn't exist yet
+     *
+     * @param state
+     * @return profile_t* nullptr if the maximum number of profiled states has been reached
+     */
+    profile_t *getProfile(SYSTEM_FLAGS_T state)
+    {
+        if (_lastProfile < _numProfiles && _profiles[_lastProfile].state == state)
+        {
+            return &_profiles[_lastProfile];
+        }
+
+        for (size_t i = 0; i < _numProfiles; i++)
+        {
+            if (_profiles[i].state == state)
+            {
+                _lastProfile = i;
+                return &_profiles[i];
+            }
+        }
+
+        if (_numProfiles == N_PROFILED_STATES)
+        {
+            return nullptr;
+        }
+
+        _lastProfile = _numProfiles++;
+        profile_t &profile = _profiles[_lastProfile];
+        profile.state = state;
+        profile.budget = 0;
+        profile.overruns = 0;
+        profile.stats.reset();
+        return &profile;
+    };
+
+    template <typename T>
+    static void appendBytes(std::vector<uint8_t> &buf, const T &value)
+    {
+        const size_t offset = buf.size();
+        buf.resize(offset + sizeof(T));
+        std::memcpy(buf.data() + offset, &value, sizeof(T));
+    };
+};
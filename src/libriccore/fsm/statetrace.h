@@ -0,0 +1,287 @@
+#pragma once
+/**
+ * @file statetrace.h
+ * @brief Fixed size binary trace of statemachine transitions. Every transition is recorded into a ring of N_EVENTS
+ * entries without allocation, overwriting the oldest entry once full. The ring is single producer (the statemachine) and
+ * can be read lock-free from any thread, entries which were overwritten while being copied are discarded. Per state cumulative
+ * time and maximum update execution time are tracked alongside for profiling.
+ * The trace can be dumped after the fact to a WrappedFile, or serialized into a BinaryPacket to be sent over rnp.
+ */
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <type_traits>
+
+#include <libriccore/platform/millis.h>
+#include <libriccore/storage/wrappedfile.h>
+
+#include "statemonitor.h"
+
+template <typename SYSTEM_FLAGS_T, size_t N_EVENTS = 64>
+class StateTrace : public StateMonitor<SYSTEM_FLAGS_T>
+{
+    using monitor_t = StateMonitor<SYSTEM_FLAGS_T>;
+
+public:
+    using stateIndex_t = typename monitor_t::stateIndex_t;
+
+    /**
+     * @brief Maximum number of states which can be tracked, one per bit of the system flags or one per wide flag
+     *
+     */
+    static constexpr size_t N_STATES = monitor_t::N_STATES;
+
+    /**
+     * @brief Trace entry. States are recorded by index (the position of the state flag bit or the wide flag value,
+     * NO_STATE if there was none) so flags above bit 31 of a 64 bit flag enum aren't truncated. Serialized as 20 bytes, little endian
+     * uint64 timestamp, uint16 from, uint16 to, uint32 dwell, uint32 update_count.
+     *
+     */
+    struct event_t
+    {
+        uint64_t timestamp;    // monotonic time of transition [us]
+        stateIndex_t from;     // exited state index
+        stateIndex_t to;       // entered state index
+        uint32_t dwell;        // time spent in exited state [ms]
+        uint32_t update_count; // number of updates of the exited state
+    };
+
+    /**
+     * @brief Size of a serialized event_t [bytes]
+     *
+     */
+    static constexpr size_t EVENT_SIZE = sizeof(uint64_t) + 2 * sizeof(stateIndex_t) + 2 * sizeof(uint32_t);
+
+    /**
+     * @brief Per state profiling information
+     *
+     */
+    struct state_stats_t
+    {
+        uint64_t cumulative_time; // total time spent in state [ms]
+        uint32_t entries;         // number of times state was entered
+        uint32_t max_update_time; // longest update execution time [us]
+    };
+
+    StateTrace() : _head(0),
+                   _claimed(0),
+                   _stats(){};
+
+    void onTransition(SYSTEM_FLAGS_T from, SYSTEM_FLAGS_T to, uint32_t dwell, uint32_t update_count) override
+    {
+        const stateIndex_t fromIndex = monitor_t::stateIndex(from);
+        record(fromIndex, to, dwell, update_count);
+        _stats[fromIndex].cumulative_time += dwell;
+    };
+
+    void onInitialState(SYSTEM_FLAGS_T to) override
+    {
+        record(monitor_t::NO_STATE, to, 0, 0);
+    };
+
+    void onUpdate(SYSTEM_FLAGS_T state, uint32_t execution_time) override
+    {
+        state_stats_t &stats = _stats[monitor_t::stateIndex(state)];
+        if (execution_time > stats.max_update_time)
+        {
+            stats.max_update_time = execution_time;
+        }
+    };
+
+    /**
+     * @brief Copies the current trace into dest ordered oldest to newest. Safe to call from any thread.
+     *
+     * @param dest
+     * @return size_t number of valid entries copied
+     */
+    size_t snapshot(std::array<event_t, N_EVENTS> &dest) const
+    {
+        const uint32_t end = _head.load(std::memory_order_acquire);
+        const uint32_t begin = (end > N_EVENTS) ? end - N_EVENTS : 0;
+
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const slot_t &slot = _events[i % N_EVENTS];
+            const uint64_t timestamp = (static_cast<uint64_t>(slot.timestamp_high.load(std::memory_order_relaxed)) << 32) |
+                                       slot.timestamp_low.load(std::memory_order_relaxed);
+            dest[i - begin] = event_t{timestamp,
+                                      slot.from.load(std::memory_order_relaxed),
+                                      slot.to.load(std::memory_order_relaxed),
+                                      slot.dwell.load(std::memory_order_relaxed),
+                                      slot.update_count.load(std::memory_order_relaxed)};
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // any entries the producer has claimed to write over while we were copying are discarded
+        const uint32_t claimed = _claimed.load(std::memory_order_relaxed);
+        const uint32_t validBegin = (claimed > N_EVENTS) ? claimed - N_EVENTS : 0;
+
+        if (validBegin <= begin)
+        {
+            return end - begin;
+        }
+
+        if (validBegin >= end)
+        {
+            return 0;
+        }
+
+        const size_t discarded = validBegin - begin;
+        std::memmove(dest.data(), dest.data() + discarded, (end - validBegin) * sizeof(event_t));
+        return end - validBegin;
+    };
+
+    /**
+     * @brief Get the profiling information of a given state. Should be called from the same thread as the statemachine.
+     *
+     * @param state
+     * @return const state_stats_t&
+     */
+    const state_stats_t &getStats(SYSTEM_FLAGS_T state) const
+    {
+        return _stats[monitor_t::stateIndex(state)];
+    };
+
+    /**
+     * @brief Total number of transitions recorded, including those which have been overwritten
+     *
+     * @return uint32_t
+     */
+    uint32_t getTransitionCount() const
+    {
+        return _head.load(std::memory_order_acquire);
+    };
+
+    /**
+     * @brief Serializes the trace followed by the stats of every state which has been entered.
+     * Format: uint32 event count, event_t[count] (EVENT_SIZE bytes each), uint32 state count,
+     * {uint16 state index, state_stats_t}[count]
+     *
+     * @param buf buffer to append to
+     */
+    void serialize(std::vector<uint8_t> &buf) const
+    {
+        std::array<event_t, N_EVENTS> events;
+        const uint32_t eventCount = snapshot(events);
+
+        appendBytes(buf, eventCount);
+        buf.reserve(buf.size() + eventCount * EVENT_SIZE);
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            const event_t &event = events[i];
+            appendBytes(buf, event.timestamp);
+            appendBytes(buf, event.from);
+            appendBytes(buf, event.to);
+            appendBytes(buf, event.dwell);
+            appendBytes(buf, event.update_count);
+        }
+
+        uint32_t stateCount = 0;
+        for (const state_stats_t &stats : _stats)
+        {
+            stateCount += (stats.entries > 0);
+        }
+        appendBytes(buf, stateCount);
+
+        for (size_t i = 0; i < N_STATES; i++)
+        {
+            if (_stats[i].entries == 0)
+            {
+                continue;
+            }
+            appendBytes(buf, static_cast<stateIndex_t>(i));
+            appendBytes(buf, _stats[i]);
+        }
+    };
+
+    /**
+     * @brief Dumps the serialized trace to the given file
+     *
+     * @param file
+     */
+    void dump(WrappedFile &file) const
+    {
+        std::vector<uint8_t> buf;
+        serialize(buf);
+        file.append(buf);
+    };
+
+    /**
+     * @brief Clears the profiling information. The trace itself is not cleared.
+     *
+     */
+    void resetStats()
+    {
+        _stats = {};
+    };
+
+private:
+    /**
+     * @brief The timestamp is split into two words so every member stays lock free on 32 bit targets, a torn
+     * timestamp is discarded like any other entry overwritten during a snapshot
+     *
+     */
+    struct slot_t
+    {
+        std::atomic<uint32_t> timestamp_low;
+        std::atomic<uint32_t> timestamp_high;
+        std::atomic<stateIndex_t> from;
+        std::atomic<stateIndex_t> to;
+        std::atomic<uint32_t> dwell;
+        std::atomic<uint32_t> update_count;
+    };
+
+    std::array<slot_t, N_EVENTS> _events;
+
+    /**
+     * @brief Index of the next entry to be written
+     *
+     */
+    std::atomic<uint32_t> _head;
+
+    /**
+     * @brief Index of the last entry the producer has started writing + 1
+     *
+     */
+    std::atomic<uint32_t> _claimed;
+
+    std::array<state_stats_t, N_STATES> _stats;
+
+    /**
+     * @brief Writes a trace entry and counts the entry into the new state
+     *
+     */
+    void record(stateIndex_t fromIndex, SYSTEM_FLAGS_T to, uint32_t dwell, uint32_t update_count)
+    {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        slot_t &slot = _events[head % N_EVENTS];
+
+        // claim the slot before overwriting it so readers can discard it if they race with this write
+        _claimed.store(head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const uint64_t timestamp = micros64();
+        slot.timestamp_low.store(static_cast<uint32_t>(timestamp), std::memory_order_relaxed);
+        slot.timestamp_high.store(static_cast<uint32_t>(timestamp >> 32), std::memory_order_relaxed);
+        slot.from.store(fromIndex, std::memory_order_relaxed);
+        slot.to.store(monitor_t::stateIndex(to), std::memory_order_relaxed);
+        slot.dwell.store(dwell, std::memory_order_relaxed);
+        slot.update_count.store(update_count, std::memory_order_relaxed);
+
+        // publish the entry
+        _head.store(head + 1, std::memory_order_release);
+
+        ++_stats[monitor_t::stateIndex(to)].entries;
+    };
+
+    template <typename T>
+    static void appendBytes(std::vector<uint8_t> &buf, const T &value)
+    {
+        const size_t offset = buf.size();
+        buf.resize(offset + sizeof(T));
+        std::memcpy(buf.data() + offset, &value, sizeof(T));
+    };
+};
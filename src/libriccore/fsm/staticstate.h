@@ -0,0 +1,133 @@
+#pragma once
+/**
+ * @file staticstate.h
+ * @brief Base class for a state used by the StaticStateMachine. Mirrors State but without any virtual dispatch
+ * or heap allocation, the state machine holds the concrete state type in preallocated storage and calls the
+ * derived initialize/update/exit methods directly. Derived states hide these methods rather than overriding them.
+ */
+#include <cstdint>
+
+#include "libriccore/systemstatus/systemstatus.h"
+
+#include <libriccore/platform/millis.h>
+
+/**
+ * @brief Transition request returned from StaticState::update. A default constructed transition means stay in the
+ * current state. Transitions are generated with StaticStateTransition::to<NEW_STATE_T>() which allows states to
+ * request a transition to another state without knowing the type of the state machine they belong to.
+ *
+ */
+struct StaticStateTransition
+{
+  /**
+   * @brief Generate a transition to the given state type
+   *
+   * @tparam STATE_T type of state to transition to, must be one of the states of the state machine
+   * @return constexpr StaticStateTransition
+   */
+  template <typename STATE_T>
+  static constexpr StaticStateTransition to()
+  {
+    return StaticStateTransition{&tag<STATE_T>};
+  };
+
+  /**
+   * @brief Check if the transition targets the given state type
+   *
+   * @tparam STATE_T
+   * @return true
+   * @return false
+   */
+  template <typename STATE_T>
+  constexpr bool targets() const
+  {
+    return target == &tag<STATE_T>;
+  };
+
+  /**
+   * @brief Returns true if a transition has been requested
+   *
+   */
+  constexpr explicit operator bool() const
+  {
+    return target != nullptr;
+  };
+
+  /**
+   * @brief Unique address per state type used to identify the target state
+   *
+   */
+  const void *target = nullptr;
+
+private:
+  template <typename STATE_T>
+  static constexpr char tag = 0;
+};
+
+template <typename SYSTEM_FLAGS_T>
+class StaticState
+{
+
+public:
+  /**
+   * @brief Constructor - requires system status object
+   *
+   * @param ID
+   * @param systemstatus
+   */
+  StaticState(SYSTEM_FLAGS_T ID, SystemStatus<SYSTEM_FLAGS_T> &systemstatus) : stateID(ID),
+                                                                              _systemstatus(systemstatus){};
+
+  /**
+   * @brief Initialize the state, records entry time
+   *
+   */
+  void initialize()
+  {
+    time_entered_state = micros64() / 1000;
+    _systemstatus.newFlag(stateID, "state entered");
+  };
+
+  /**
+   * @brief Update hook for state. Return a default constructed StaticStateTransition to loop the state, otherwise
+   * return StaticStateTransition::to<NEW_STATE_T>() for the desired new state.
+   *
+   * @return StaticStateTransition
+   */
+  StaticStateTransition update()
+  {
+    return {};
+  };
+
+  /**
+   * @brief Exit state transition, records exit and duration time. The duration is not logged to avoid
+   * allocating on every transition, attach a StateTrace to the statemachine to record it.
+   *
+   */
+  void exit()
+  {
+    time_exited_state = micros64() / 1000;
+    time_duration_state = time_exited_state - time_entered_state;
+    _systemstatus.deleteFlag(stateID, "state exited");
+  };
+
+  /**
+   * @brief Returns state id which is a system flag
+   *
+   * @return SYSTEM_FLAGS
+   */
+  SYSTEM_FLAGS_T getID() const
+  {
+    return stateID;
+  };
+
+protected:
+  const SYSTEM_FLAGS_T stateID;
+
+  // monotonic state entry and exit times [ms], derived from micros64() so they never wrap
+  uint64_t time_entered_state;
+  uint64_t time_exited_state;
+  uint64_t time_duration_state;
+
+  SystemStatus<SYSTEM_FLAGS_T> &_systemstatus;
+};
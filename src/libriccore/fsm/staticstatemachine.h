@@ -0,0 +1,226 @@
+/**
+ * @file staticstatemachine.h
+ * @brief Statemachine implementing state transitions without heap allocation. All possible states are
+ * given as template parameters and the active state is constructed in place inside a std::variant, so a transition
+ * only calls exit on the old state, constructs the new state in the same storage and calls initialize.
+ */
+
+#pragma once
+
+#include <variant>
+#include <type_traits>
+#include <stdexcept>
+#include <vector>
+
+#include <libriccore/platform/millis.h>
+
+#include "staticstate.h"
+#include "statemonitor.h"
+
+/**
+ * @brief Statemachine with preallocated state storage.
+ *
+ * @tparam SYSTEM_FLAG_T Enum of system flags
+ * @tparam CONTEXT_T Type passed by reference to the constructor of every state, typically the derived system class
+ * @tparam STATES All state types the statemachine can hold. Each must derive from StaticState<SYSTEM_FLAG_T>
+ * and be constructible from CONTEXT_T&
+ */
+template <typename SYSTEM_FLAG_T, typename CONTEXT_T, typename... STATES>
+class StaticStateMachine
+{
+  static_assert(sizeof...(STATES) > 0, "StaticStateMachine requires at least one state!");
+  static_assert((std::is_base_of_v<StaticState<SYSTEM_FLAG_T>, STATES> && ...), "All states must derive from StaticState<SYSTEM_FLAG_T>!");
+  static_assert((std::is_constructible_v<STATES, CONTEXT_T &> && ...), "All states must be constructible from CONTEXT_T&!");
+
+public:
+  /**
+   * @brief Construct the state machine, no state is active until initalize is called
+   *
+   * @param context reference passed to the constructor of each state
+   */
+  StaticStateMachine(CONTEXT_T &context) : _context(context),
+                                           currState(std::monostate{}){};
+
+  /**
+   * @brief Initalize state machine with inital state type
+   *
+   * @tparam INITIAL_STATE_T
+   */
+  template <typename INITIAL_STATE_T>
+  void initalize()
+  {
+    changeState<INITIAL_STATE_T>();
+  };
+
+  /**
+   * @brief Update hook for the statemachine. Calls update on the active state. If the state returns a transition,
+   * the statemachine will change to the requested state.
+   *
+   */
+  void update()
+  {
+    const uint32_t updateStart = monitors.empty() ? 0 : micros();
+
+    const StaticStateTransition transition = std::visit([](auto &state) -> StaticStateTransition
+                                                        {
+                                                          if constexpr (std::is_same_v<std::decay_t<decltype(state)>, std::monostate>)
+                                                          {
+                                                            return {};
+                                                          }
+                                                          else
+                                                          {
+                                                            return state.update();
+                                                          } },
+                                                        currState);
+
+    if (!monitors.empty())
+    {
+      const uint32_t executionTime = micros() - updateStart;
+      for (StateMonitor<SYSTEM_FLAG_T> *monitor : monitors)
+      {
+        monitor->onUpdate(getCurrentStateID(), executionTime);
+      }
+    }
+    ++updateCount;
+
+    if (transition)
+    {
+      changeState(transition);
+    }
+  };
+
+  /**
+   * @brief Method forces statemachine to change state. Exit is called on the current state before it is destroyed
+   * and the new state is constructed in its place.
+   *
+   * @tparam NEW_STATE_T
+   */
+  template <typename NEW_STATE_T>
+  void changeState()
+  {
+    static_assert((std::is_same_v<NEW_STATE_T, STATES> || ...), "State is not part of this StaticStateMachine!");
+
+    const SYSTEM_FLAG_T previousStateID = getCurrentStateID();
+    const bool hadState = !std::holds_alternative<std::monostate>(currState);
+
+    exitCurrentState();
+    NEW_STATE_T &newState = currState.template emplace<NEW_STATE_T>(_context);
+    newState.initialize();
+
+    const uint32_t previousUpdateCount = updateCount;
+    updateCount = 0;
+
+    // always record the entry time so a monitor attached later doesn't measure its first dwell from a stale time
+    const uint32_t now = millis();
+    const uint32_t dwellTime = now - timeEnteredState;
+    timeEnteredState = now;
+
+    for (StateMonitor<SYSTEM_FLAG_T> *monitor : monitors)
+    {
+      if (!hadState)
+      {
+        monitor->onInitialState(newState.getID());
+        continue;
+      }
+      monitor->onTransition(previousStateID, newState.getID(), dwellTime, previousUpdateCount);
+    }
+  };
+
+  /**
+   * @brief Change state using a transition returned from a state. Throws std::runtime_error if the transition
+   * targets a state which is not part of this statemachine.
+   *
+   * @param transition
+   */
+  void changeState(const StaticStateTransition &transition)
+  {
+    if (!(tryChangeState<STATES>(transition) || ...))
+    {
+      throw std::runtime_error("Transition to state not in StaticStateMachine!");
+    }
+  };
+
+  /**
+   * @brief Returns the id of the current state, returns a zero flag if no state is active
+   *
+   * @return SYSTEM_FLAG_T
+   */
+  SYSTEM_FLAG_T getCurrentStateID() const
+  {
+    return std::visit([](const auto &state) -> SYSTEM_FLAG_T
+                      {
+                        if constexpr (std::is_same_v<std::decay_t<decltype(state)>, std::monostate>)
+                        {
+                          return static_cast<SYSTEM_FLAG_T>(0);
+                        }
+                        else
+                        {
+                          return state.getID();
+                        } },
+                      currState);
+  };
+
+  /**
+   * @brief Returns a pointer to the current state if it is of type STATE_T, otherwise nullptr
+   *
+   * @tparam STATE_T
+   * @return STATE_T*
+   */
+  template <typename STATE_T>
+  STATE_T *getCurrentState()
+  {
+    return std::get_if<STATE_T>(&currState);
+  };
+
+  /**
+   * @brief Attach a monitor (e.g. StateTrace) which is notified of every transition and update. The monitor must
+   * outlive the statemachine. When no monitors are attached, update is not timed.
+   *
+   * @param monitor
+   */
+  void addMonitor(StateMonitor<SYSTEM_FLAG_T> &monitor)
+  {
+    monitors.push_back(&monitor);
+  };
+
+private:
+  CONTEXT_T &_context;
+
+  std::variant<std::monostate, STATES...> currState;
+
+  std::vector<StateMonitor<SYSTEM_FLAG_T> *> monitors;
+
+  /**
+   * @brief Time the current state was entered [ms]
+   *
+   */
+  uint32_t timeEnteredState = 0;
+
+  /**
+   * @brief Number of updates of the current state
+   *
+   */
+  uint32_t updateCount = 0;
+
+  void exitCurrentState()
+  {
+    std::visit([](auto &state)
+               {
+                 if constexpr (!std::is_same_v<std::decay_t<decltype(state)>, std::monostate>)
+                 {
+                   state.exit();
+                 } },
+               currState);
+  };
+
+  template <typename STATE_T>
+  bool tryChangeState(const StaticStateTransition &transition)
+  {
+    if (!transition.template targets<STATE_T>())
+    {
+      return false;
+    }
+    changeState<STATE_T>();
+    return true;
+  };
+};
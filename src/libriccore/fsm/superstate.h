@@ -0,0 +1,93 @@
+#pragma once
+/**
+ * @file superstate.h
+ * @brief Hierarchical state. A super state owns a nested statemachine of substates which share the behaviour
+ * implemented in the super state. On each update the super state runs parentUpdate first, which can pre-empt the
+ * substates by returning a new state, otherwise the active substate is updated. Entry order is parent then child,
+ * exit order is child then parent, so the parent flag is always raised while any of its substate flags are.
+ */
+#include <memory>
+
+#include "state.h"
+#include "statemachine.h"
+
+template <typename SYSTEM_FLAGS_T>
+class SuperState : public State<SYSTEM_FLAGS_T>
+{
+public:
+  SuperState(SYSTEM_FLAGS_T ID, SystemStatus<SYSTEM_FLAGS_T> &systemstatus) : State<SYSTEM_FLAGS_T>(ID, systemstatus){};
+
+  /**
+   * @brief Enter the super state, then enter the initial substate
+   *
+   */
+  void initialize() override
+  {
+    State<SYSTEM_FLAGS_T>::initialize();
+    substatemachine.initalize(initialSubstate());
+  };
+
+  /**
+   * @brief Runs the parent update, if this returns a new state the substates are pre-empted and the new state is
+   * returned to the owning statemachine, otherwise the active substate is updated.
+   *
+   * @return std::unique_ptr<State<SYSTEM_FLAGS_T>>
+   */
+  std::unique_ptr<State<SYSTEM_FLAGS_T>> update() final
+  {
+    std::unique_ptr<State<SYSTEM_FLAGS_T>> preemptState = parentUpdate();
+
+    if (preemptState)
+    {
+      return preemptState;
+    }
+
+    substatemachine.update();
+    return nullptr;
+  };
+
+  /**
+   * @brief Exit the active substate, then exit the super state
+   *
+   */
+  void exit() override
+  {
+    substatemachine.exit();
+    State<SYSTEM_FLAGS_T>::exit();
+  };
+
+  /**
+   * @brief Returns the id of the active substate
+   *
+   * @return SYSTEM_FLAGS_T
+   */
+  SYSTEM_FLAGS_T getSubstateID()
+  {
+    return substatemachine.getCurrentStateID();
+  };
+
+protected:
+  /**
+   * @brief Returns the substate entered when the super state is entered
+   *
+   * @return std::unique_ptr<State<SYSTEM_FLAGS_T>>
+   */
+  virtual std::unique_ptr<State<SYSTEM_FLAGS_T>> initialSubstate() = 0;
+
+  /**
+   * @brief Shared behaviour of all substates, called before the active substate is updated. Return nullptr to
+   * continue updating the substate, otherwise return the state to transition the owning statemachine to.
+   *
+   * @return std::unique_ptr<State<SYSTEM_FLAGS_T>>
+   */
+  virtual std::unique_ptr<State<SYSTEM_FLAGS_T>> parentUpdate()
+  {
+    return nullptr;
+  };
+
+  /**
+   * @brief Nested statemachine holding the active substate
+   *
+   */
+  StateMachine<SYSTEM_FLAGS_T> substatemachine;
+};
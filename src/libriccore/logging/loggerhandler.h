@@ -13,6 +13,7 @@
 #include <tuple>
 
 #include "libriccore/util/istuple.h"
+#include "libriccore/threading/scopedlock.h"
 
 #include "loggerhandler_config_tweak.h"
 
@@ -27,6 +28,9 @@
  *  The general structre of this singleton follows the meyer singleton with the key difference of making the getInstance method private.
  * Access to this function is managed thru friend interface classes ensuring that only the RicCoreSystem class has access to the getInstance 
  * method. The reference returned can then be DI'ed to whatever management objects or methods may exist in the System class.
+ * Log calls and update are serialised by a single lock, so loggers can be called from other threads than the control loop
+ * (e.g the network thread of the PipelinedNetworkManager) without each logger implementing its own locking. A log call
+ * made from inside a logger on the same thread (e.g a logger reporting its own error) doesn't take the lock again.
  * 
  */
 
@@ -62,6 +66,7 @@ class LoggerHandler{
          */
         void update()
         {
+            LogGuard lg(*this);
             std::apply(
                 [](auto &&...loggers) 
                 {
@@ -74,6 +79,49 @@ class LoggerHandler{
         // Interface class friendships
         friend struct ILoggerHandler;
         friend struct RicCoreLogging;
+
+        /**
+         * @brief Holds the log lock for its lifetime unless this thread already holds it
+         * 
+         */
+        class LogGuard
+        {
+            public:
+                LogGuard(LoggerHandler& handler):
+                _handler(handler),
+                _owner(!_logging)
+                {
+                    if (_owner)
+                    {
+                        _handler._logLock.acquire();
+                        _logging = true;
+                    }
+                };
+
+                ~LogGuard()
+                {
+                    if (_owner)
+                    {
+                        _logging = false;
+                        _handler._logLock.release();
+                    }
+                };
+
+                LogGuard(const LogGuard&) = delete;
+                LogGuard& operator=(const LogGuard&) = delete;
+
+            private:
+                LoggerHandler& _handler;
+                const bool _owner;
+        };
+
+        RicCoreThread::Lock_t _logLock;
+
+        /**
+         * @brief True while this thread holds the log lock
+         * 
+         */
+        static inline thread_local bool _logging = false;
         
         /**
          * @brief Tuple containing configured loggers for the logger handler. Note this must be an inlined tuple.
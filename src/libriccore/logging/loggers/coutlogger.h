@@ -34,9 +34,9 @@ public:
         if (!enabled){return;};
         
         #ifdef ARDUINO
-        Serial.println((std::string(logger_name) + ":[" + std::to_string(millis()).c_str() + "] -> "  + std::string(msg)).c_str());
+        Serial.println((std::string(logger_name) + ":[" + std::to_string(micros64()).c_str() + "] -> "  + std::string(msg)).c_str());
         #else
-        std::cout << logger_name << ":[" + std::to_string(millis()) + "] -> " << msg << "\n";
+        std::cout << logger_name << ":[" + std::to_string(micros64()) + "] -> " << msg << "\n";
         #endif
     };
 
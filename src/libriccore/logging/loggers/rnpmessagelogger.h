@@ -14,6 +14,7 @@
 
 #include <iostream>
 #include <string>
+#include <functional>
 #include <libriccore/platform/millis.h>
 
 #include <librnp/rnp_packet.h>
@@ -33,9 +34,18 @@ public:
                                               {};
                                               
 
-    void initialize(RnpNetworkManager& netman)
+    /**
+     * @brief Initialize with the network manager to send log messages with. Messages are sent through the passed
+     * type, so a PipelinedNetworkManager queues messages to its network thread.
+     * 
+     * @tparam NETMAN_T RnpNetworkManager or derived type
+     * @param netman 
+     */
+    template <typename NETMAN_T>
+    void initialize(NETMAN_T& netman)
     {
         _netman = &netman;
+        _send = [&netman](RnpPacket& packet){netman.sendPacket(packet);};
         initialized = true;
     };
 
@@ -61,7 +71,7 @@ public:
         message.header.destination_service=destinationService;
         message.header.uid = 0;
 
-        _netman->sendPacket(message);
+        _send(message);
         
        
     };
@@ -92,4 +102,10 @@ private:
      * 
      */
     RnpNetworkManager* _netman;
+
+    /**
+     * @brief Send function bound to the network manager type passed to initialize
+     * 
+     */
+    std::function<void(RnpPacket&)> _send;
 };
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include <exception>
 #include <functional>
 #include <string_view>
+#include <type_traits>
 
 #include <libriccore/platform/millis.h>
 #include <libriccore/storage/wrappedfile.h>
@@ -57,10 +58,12 @@ public:
     /**
      * @brief Initalize both file and network logging
      *
+     * @tparam NETMAN_T RnpNetworkManager or derived type
      * @param file
      * @param netman
      */
-    bool initialize(std::unique_ptr<WrappedFile> file, RnpNetworkManager &netman, std::function<void(std::string_view message)> logcb = nullptr)
+    template <typename NETMAN_T, typename = std::enable_if_t<std::is_base_of_v<RnpNetworkManager, NETMAN_T>>>
+    bool initialize(std::unique_ptr<WrappedFile> file, NETMAN_T &netman, std::function<void(std::string_view message)> logcb = nullptr)
     {
         rnpmessagelogger.initialize(netman);
         return initialize(std::move(file), logcb);
@@ -111,7 +114,7 @@ private:
             return;
         };
         // construct data frame to write to file
-        const std::string dataframe_string = std::to_string(millis()) + "," + std::string(msg) + "," + std::to_string(flag) + "," + std::to_string(status) + ",\n";
+        const std::string dataframe_string = std::to_string(micros64()) + "," + std::string(msg) + "," + std::to_string(flag) + "," + std::to_string(status) + ",\n";
 
         std::vector<uint8_t> dataframe_bytes(dataframe_string.begin(), dataframe_string.end());
 
@@ -18,7 +18,9 @@
 #include <vector>
 #include <string>
 #include <queue>
+#include <algorithm>
 #include <unordered_map>
+#include <functional>
 
 #include <librnp/rnp_interface.h>
 #include <librnp/rnp_packet.h>
@@ -28,6 +30,7 @@
 
 #include <libriccore/riccorelogging.h>
 #include <libriccore/systemstatus/systemstatus.h>
+#include <libriccore/profiling/loopprofiler.h>
 
 #include "rnpcanidentifier.h"
 
@@ -38,13 +41,29 @@ struct CanBusInterfaceInfo : public RnpInterfaceInfo
 
     bool sendBufferOverflow;
     bool receiveBufferOverflow;
+
+    /**
+     * @brief Number of partially re-assembled packets evicted from the receive buffer as their expiry deadline passed
+     *
+     */
+    uint32_t receiveBufferEvictions;
 };
 
 template <typename SYSTEM_FLAGS_T, RicCoreLoggingConfig::LOGGERS LOGGING_TARGET = RicCoreLoggingConfig::LOGGERS::SYS>
 class CanBus : public RnpInterface
 {
 public:
-    CanBus(SystemStatus<SYSTEM_FLAGS_T> &systemstatus, const uint8_t TxCan, const uint8_t RxCan, uint8_t id, std::string name = "Can0") : RnpInterface(id, name),
+    /**
+     * @brief Construct a new Can Bus interface
+     *
+     * @param systemstatus
+     * @param TxCan tx gpio
+     * @param RxCan rx gpio
+     * @param id interface id
+     * @param name interface name
+     * @param receiveBufferExpiry time in ms a partially re-assembled packet may go without receiving a new segment before it is evicted
+     */
+    CanBus(SystemStatus<SYSTEM_FLAGS_T> &systemstatus, const uint8_t TxCan, const uint8_t RxCan, uint8_t id, std::string name = "Can0", uint32_t receiveBufferExpiry = 50) : RnpInterface(id, name),
                                                                                                                                           _systemstatus(systemstatus),
                                                                                                                                           can_general_config(
                                                                                                                                               {
@@ -59,11 +78,16 @@ public:
                                                                                                                                                   .clkout_divider = 0,
                                                                                                                                               }),
                                                                                                                                           can_timing_config(TWAI_TIMING_CONFIG_1MBITS()),
-                                                                                                                                          can_filter_config(TWAI_FILTER_CONFIG_ACCEPT_ALL())
+                                                                                                                                          can_filter_config(TWAI_FILTER_CONFIG_ACCEPT_ALL()),
+                                                                                                                                          _receiveBufferExpiry(receiveBufferExpiry)
     {
         _info.MTU = 256;                  // theoretical maximum is 2048 but this is very chonky
         _info.maxSendBufferElements = 20; // maximum of 10 buffered rnp packets equating to a potential maximum of 2.56kb of buffer storage + sizeof(rnpcanidentifer)*10
         _info.maxReceiveBufferElements = 20;
+        _info.receiveBufferEvictions = 0;
+
+        // preallocate the expiry heap, pushExpiry compacts stale entries rather than growing past this
+        _receiveBufferExpiryHeap.reserve(_info.maxReceiveBufferElements * 2);
     };
 
     void setup() override
@@ -94,10 +118,7 @@ public:
         if (_sendBuffer.size() + 1 > _info.maxSendBufferElements)
         {
 
-            if (!_systemstatus.flagSet(SYSTEM_FLAGS_T::ERROR_CAN))
-            {
-                _systemstatus.newFlag(SYSTEM_FLAGS_T::ERROR_CAN, "Can Send Buffer Overflow!");
-            }
+            _systemstatus.newFlag(SYSTEM_FLAGS_T::ERROR_CAN, "Can Send Buffer Overflow!");
             _info.sendBufferOverflow = true;
             return;
         }
@@ -106,7 +127,7 @@ public:
         data.serialize(serializedPacket);
         _sendBuffer.emplace(send_buffer_element_t{RnpCanIdentifier(data.header, generateCanPacketId()), serializedPacket});
 
-        if (_info.sendBufferOverflow && _systemstatus.flagSetOr(SYSTEM_FLAGS_T::ERROR_CAN))
+        if (_info.sendBufferOverflow)
         {
             _systemstatus.deleteFlag(SYSTEM_FLAGS_T::ERROR_CAN, "Can Send Buffer no longer overflowing!");
             _info.sendBufferOverflow = false;
@@ -116,6 +137,7 @@ public:
 
     void update() override
     {
+        RICCORE_PROFILE_SCOPE("CanBus");
         busRecovery();
 
         for (uint8_t i = 0; i < 16; i++)
@@ -124,14 +146,18 @@ public:
             processReceivedPackets();
         }
 
-        if (millis() - prevTime > cleanup_delta)
-        {
-            cleanupReceiveBuffer();
-            prevTime = millis();
-        }
+        expireReceiveBuffer();
     };
     const RnpInterfaceInfo *getInfo() override { return &_info; };
 
+    /**
+     * @brief Set the time a partially re-assembled packet may go without receiving a new segment before it is evicted
+     * from the receive buffer. This should be on the order of a single packet's worth of bus time.
+     *
+     * @param expiry expiry time in ms
+     */
+    void setReceiveBufferExpiry(uint32_t expiry) { _receiveBufferExpiry = expiry; };
+
     /**
      * @brief Set the Hardware Acceptance Filter. Will uninstall and reinstall can driver
      * NOT IMPLEMENTED YET!
@@ -163,8 +189,6 @@ private:
         return can_packet_id;
     };
 
-    static constexpr uint32_t receive_buffer_expiry = 120 * 1000; // 2 minute expiry time
-
     struct send_buffer_element_t
     {
         RnpCanIdentifier canidentifier;
@@ -182,7 +206,8 @@ private:
         std::vector<uint8_t> bytedata;
         size_t expected_size;
         uint8_t seg_id;
-        uint32_t last_time_modified;
+        uint64_t last_time_modified; // monotonic [us]
+        uint32_t generation;
     };
 
     /**
@@ -191,6 +216,49 @@ private:
      */
     std::unordered_map<uint32_t, receive_buffer_element_t> _receiveBuffer;
 
+    /**
+     * @brief Deadline entry for a receive buffer slot. The generation is used to identify entries which refer
+     * to a slot which has since been erased (and potentially re-created with the same uid) so they can be lazily discarded.
+     *
+     */
+    struct expiry_element_t
+    {
+        uint64_t deadline; // monotonic [us]
+        uint32_t can_packet_uid;
+        uint32_t generation;
+    };
+
+    /**
+     * @brief Orders expiry elements so the earliest deadline is at the top of the heap
+     *
+     */
+    struct expiry_compare_t
+    {
+        bool operator()(const expiry_element_t &a, const expiry_element_t &b) const
+        {
+            return a.deadline > b.deadline;
+        };
+    };
+
+    /**
+     * @brief Min-heap of receive buffer slot deadlines, maintained with std::push_heap/pop_heap. Entries for slots
+     * which have completed stay in the heap until their deadline or the next compaction.
+     *
+     */
+    std::vector<expiry_element_t> _receiveBufferExpiryHeap;
+
+    /**
+     * @brief Time in ms a receive buffer slot can go without being modified before it is evicted
+     *
+     */
+    uint32_t _receiveBufferExpiry;
+
+    /**
+     * @brief Incrementing counter to tag each new receive buffer slot
+     *
+     */
+    uint32_t _receiveBufferGeneration{0};
+
     bool _installsuccess = true;
     bool _startsuccess = true;
 
@@ -243,6 +311,7 @@ private:
         {
             if (err != ESP_ERR_TIMEOUT)
             {
+                // only build the message on the rising edge, the flag is already raised on repeated failures
                 if (!_systemstatus.flagSetOr(SYSTEM_FLAGS_T::ERROR_CAN))
                 {
                     _systemstatus.newFlag(SYSTEM_FLAGS_T::ERROR_CAN, "Can Receive failed with error code" + std::to_string(err));
@@ -286,6 +355,7 @@ private:
             if (_receiveBuffer.size() == _info.maxReceiveBufferElements)
             {
                 _info.receiveBufferOverflow = true;
+                // only build the message on the rising edge, the flag is already raised on repeated failures
                 if (!_systemstatus.flagSetOr(SYSTEM_FLAGS_T::ERROR_CAN))
                 {
                     _systemstatus.newFlag(SYSTEM_FLAGS_T::ERROR_CAN, "Can Receive Buffer Overflow" + std::to_string(err));
@@ -293,13 +363,19 @@ private:
                 return;
             }
 
+            const uint64_t time_received = micros64();
+            const uint32_t generation = ++_receiveBufferGeneration;
+
             _receiveBuffer.emplace(can_packet_uid,
                                    receive_buffer_element_t{std::vector<uint8_t>(can_packet.data, can_packet.data + can_packet.data_length_code),
                                                             0,
                                                             0,
-                                                            millis()});
+                                                            time_received,
+                                                            generation});
+
+            pushExpiry(expiry_element_t{time_received + static_cast<uint64_t>(_receiveBufferExpiry) * 1000, can_packet_uid, generation});
 
-            if (_info.receiveBufferOverflow && _systemstatus.flagSetOr(SYSTEM_FLAGS_T::ERROR_CAN))
+            if (_info.receiveBufferOverflow)
             {
                 _systemstatus.deleteFlag(SYSTEM_FLAGS_T::ERROR_CAN, "Can Receive Buffer no longer overflowing!");
                 _info.receiveBufferOverflow = false;
@@ -324,7 +400,7 @@ private:
             // copy new data
             std::memcpy(receive_buffer_element.bytedata.data() + bytedata_size, &can_packet.data, can_packet.data_length_code);
             // update last time modified
-            receive_buffer_element.last_time_modified = millis();
+            receive_buffer_element.last_time_modified = micros64();
 
             // check if the previous received can packet was the start of the rnp packet in which case we can deserialize the header to get expected length.
             if (receive_buffer_element.seg_id == 0 || receive_buffer_element.expected_size == 0)
@@ -398,6 +474,7 @@ private:
                 _txerror = false;
             }
             // proper error might be worth throwing here? -> future
+            // only build the message on the rising edge, the flag is already raised on repeated failures
             if (!_systemstatus.flagSetOr(SYSTEM_FLAGS_T::ERROR_CAN))
             {
                 _systemstatus.newFlag(SYSTEM_FLAGS_T::ERROR_CAN, "Can transmit failed with error code" + std::to_string(err));
@@ -419,26 +496,86 @@ private:
     };
 
     /**
-     * @brief How long before a cleanup is called
+     * @brief Evicts receive buffer slots whose deadline has passed. Only the slots at the top of the deadline heap are
+     * inspected, so the cost is proportional to the number of expired entries rather than the size of the receive buffer.
+     * Slots which have received a segment since their deadline was scheduled are re-scheduled rather than evicted.
      *
      */
-    static constexpr uint32_t cleanup_delta = 60 * 1000; // every minute
-    uint32_t prevTime;
-    void cleanupReceiveBuffer()
+    void expireReceiveBuffer()
     {
+        if (_receiveBufferExpiryHeap.empty())
+        {
+            return;
+        }
 
-        for (auto it = _receiveBuffer.begin(); it != _receiveBuffer.end();)
+        const uint64_t now = micros64();
+
+        while (!_receiveBufferExpiryHeap.empty())
         {
+            const expiry_element_t expiry_element = _receiveBufferExpiryHeap.front();
 
-            if (millis() - it->second.last_time_modified > receive_buffer_expiry)
+            if (now < expiry_element.deadline)
             {
-                it = _receiveBuffer.erase(it);
+                // earliest deadline is still in the future so nothing else can have expired
+                return;
             }
-            else
+
+            std::pop_heap(_receiveBufferExpiryHeap.begin(), _receiveBufferExpiryHeap.end(), expiry_compare_t{});
+            _receiveBufferExpiryHeap.pop_back();
+
+            auto it = _receiveBuffer.find(expiry_element.can_packet_uid);
+
+            if (it == _receiveBuffer.end() || it->second.generation != expiry_element.generation)
             {
-                ++it;
+                // slot was completed or dropped since the deadline was scheduled
+                continue;
             }
+
+            const uint64_t deadline = it->second.last_time_modified + static_cast<uint64_t>(_receiveBufferExpiry) * 1000;
+
+            if (now < deadline)
+            {
+                // slot has been modified since, push back the deadline
+                pushExpiry(expiry_element_t{deadline, expiry_element.can_packet_uid, expiry_element.generation});
+                continue;
+            }
+
+            _receiveBuffer.erase(it);
+            ++_info.receiveBufferEvictions;
         }
+    };
 
+    /**
+     * @brief Whether an expiry entry still refers to a live receive buffer slot
+     *
+     * @param expiry_element
+     * @return true
+     * @return false the slot was completed or dropped since the entry was scheduled
+     */
+    bool expiryLive(const expiry_element_t &expiry_element) const
+    {
+        auto it = _receiveBuffer.find(expiry_element.can_packet_uid);
+        return it != _receiveBuffer.end() && it->second.generation == expiry_element.generation;
+    };
+
+    /**
+     * @brief Schedule a deadline. If the heap is at its reserved capacity the entries of completed slots are dropped
+     * first, each live slot has exactly one entry so this leaves at most maxReceiveBufferElements entries and the heap
+     * never grows past its reserve.
+     *
+     * @param expiry_element
+     */
+    void pushExpiry(const expiry_element_t &expiry_element)
+    {
+        if (_receiveBufferExpiryHeap.size() == _receiveBufferExpiryHeap.capacity())
+        {
+            _receiveBufferExpiryHeap.erase(std::remove_if(_receiveBufferExpiryHeap.begin(), _receiveBufferExpiryHeap.end(),
+                                                          [this](const expiry_element_t &element)
+                                                          { return !expiryLive(element); }),
+                                           _receiveBufferExpiryHeap.end());
+            std::make_heap(_receiveBufferExpiryHeap.begin(), _receiveBufferExpiryHeap.end(), expiry_compare_t{});
+        }
+        _receiveBufferExpiryHeap.push_back(expiry_element);
+        std::push_heap(_receiveBufferExpiryHeap.begin(), _receiveBufferExpiryHeap.end(), expiry_compare_t{});
     };
 };
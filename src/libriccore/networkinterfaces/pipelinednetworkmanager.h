@@ -0,0 +1,234 @@
+#pragma once
+/**
+ * @file pipelinednetworkmanager.h
+ * @brief Network manager which can run the network stack on its own thread. Once startPipeline is called,
+ * RnpNetworkManager::update, and so every interface update (StreamSerial, CanBus...), runs on a dedicated thread
+ * pinned to CORE0 by default, so radio and can bursts don't add jitter to the control loop. Packets received for a
+ * service are handed to the control loop through a lock free queue and the service callback is called from update()
+ * on the control loop, so services keep running on the control loop as before. Packets sent with sendPacket from
+ * outside the network thread are queued the other way and sent by the network thread.
+ * Before startPipeline is called, and after stopPipeline, this behaves exactly like RnpNetworkManager.
+ * Register all services and interfaces and load the network config before starting the pipeline, the rest of the
+ * RnpNetworkManager api (routing, config) is not thread safe and must not be used while the pipeline is running.
+ * Note the sendPacket, registerService and update methods hide rather than override the RnpNetworkManager methods,
+ * so calls must be made through this type, not a RnpNetworkManager reference.
+ */
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+
+#include <librnp/rnp_networkmanager.h>
+#include <librnp/rnp_packet.h>
+
+#include <libriccore/threading/riccorethread.h>
+#include <libriccore/threading/scopedlock.h>
+#include <libriccore/threading/spscqueue.h>
+
+template <size_t QUEUE_SIZE = 32>
+class PipelinedNetworkManager : public RnpNetworkManager
+{
+public:
+    using serviceCallback_t = std::function<void(packetptr_t)>;
+
+    using RnpNetworkManager::RnpNetworkManager;
+
+    ~PipelinedNetworkManager()
+    {
+        stopPipeline();
+    };
+
+    /**
+     * @brief Start running the network stack on its own thread. Does nothing if already started.
+     *
+     * @param stack_size network thread stack size
+     * @param priority network thread priority
+     * @param coreID core to pin the network thread to
+     * @param loopDelay delay between network updates [ms], yields the core to other tasks
+     */
+    void startPipeline(const size_t stack_size = 8192,
+                       const int priority = 2,
+                       const RicCoreThread::Thread::CORE_ID coreID = RicCoreThread::Thread::CORE_ID::CORE0,
+                       const uint32_t loopDelay = 1)
+    {
+        if (_networkThread)
+        {
+            return;
+        }
+        _loopDelay = loopDelay;
+        _pipelineRunning.store(true, std::memory_order_release);
+        _networkThread = std::make_unique<RicCoreThread::Thread>([this](void *)
+                                                                 { networkLoop(); },
+                                                                 nullptr, stack_size, priority, coreID, "network");
+    };
+
+    /**
+     * @brief Stop the network thread and return to updating the network stack from update(). Must be called
+     * from the control loop.
+     *
+     */
+    void stopPipeline()
+    {
+        if (!_networkThread)
+        {
+            return;
+        }
+        _pipelineRunning.store(false, std::memory_order_release);
+        _networkThread.reset(); // joins the network thread
+
+        // send anything queued after the network thread stopped
+        packetptr_t packet;
+        while (_txQueue.pop(packet))
+        {
+            RnpNetworkManager::sendPacket(*packet);
+        }
+    };
+
+    bool pipelineRunning() const { return _pipelineRunning.load(std::memory_order_acquire); };
+
+    /**
+     * @brief Register a service callback. When the pipeline is running, the callback is still called from update()
+     * on the control loop.
+     *
+     * @param serviceID
+     * @param callback
+     */
+    void registerService(uint8_t serviceID, serviceCallback_t callback)
+    {
+        _services[serviceID] = std::move(callback);
+        RnpNetworkManager::registerService(serviceID, [this, serviceID](packetptr_t packet)
+                                           { receive(serviceID, std::move(packet)); });
+    };
+
+    /**
+     * @brief Send a packet. When the pipeline is running and this is called from outside the network thread, the
+     * packet is serialized and queued for the network thread, so the packet can be reused as soon as this returns.
+     * Packets are dropped and counted if the queue is full.
+     *
+     * @param packet
+     */
+    void sendPacket(RnpPacket &packet)
+    {
+        if (!pipelineRunning() || _onNetworkThread)
+        {
+            RnpNetworkManager::sendPacket(packet);
+            return;
+        }
+
+        std::vector<uint8_t> serialized;
+        packet.serialize(serialized);
+        packetptr_t packetptr = std::make_unique<RnpPacketSerialized>(serialized);
+
+        // the queue is single producer, sends from other threads than the control loop (e.g loggers) are serialised
+        RicCoreThread::ScopedLock sl(_txProducerLock);
+        if (!_txQueue.push(std::move(packetptr)))
+        {
+            ++_txDropped;
+        }
+    };
+
+    /**
+     * @brief Update from the control loop. When the pipeline is running, dispatches received packets to the
+     * service callbacks, otherwise updates the network stack.
+     *
+     */
+    void update()
+    {
+        if (!pipelineRunning())
+        {
+            RnpNetworkManager::update();
+        }
+
+        received_t received;
+        while (_rxQueue.pop(received))
+        {
+            dispatch(received.serviceID, std::move(received.packet));
+        }
+    };
+
+    /**
+     * @brief Number of received packets dropped as the control loop wasn't keeping up
+     *
+     * @return uint32_t
+     */
+    uint32_t getRxDropped() const { return _rxDropped.load(std::memory_order_relaxed); };
+
+    /**
+     * @brief Number of sent packets dropped as the network thread wasn't keeping up
+     *
+     * @return uint32_t
+     */
+    uint32_t getTxDropped() const { return _txDropped.load(std::memory_order_relaxed); };
+
+private:
+    struct received_t
+    {
+        uint8_t serviceID;
+        packetptr_t packet;
+    };
+
+    /**
+     * @brief Service callbacks, only accessed from the control loop
+     *
+     */
+    std::unordered_map<uint8_t, serviceCallback_t> _services;
+
+    RicCoreThread::SpscQueue<received_t, QUEUE_SIZE> _rxQueue;
+    RicCoreThread::SpscQueue<packetptr_t, QUEUE_SIZE> _txQueue;
+    RicCoreThread::Lock_t _txProducerLock;
+
+    std::atomic<uint32_t> _rxDropped{0};
+    std::atomic<uint32_t> _txDropped{0};
+
+    std::atomic<bool> _pipelineRunning{false};
+    uint32_t _loopDelay = 1;
+    std::unique_ptr<RicCoreThread::Thread> _networkThread;
+
+    static inline thread_local bool _onNetworkThread = false;
+
+    void networkLoop()
+    {
+        _onNetworkThread = true;
+        while (pipelineRunning())
+        {
+            packetptr_t packet;
+            while (_txQueue.pop(packet))
+            {
+                RnpNetworkManager::sendPacket(*packet);
+            }
+            RnpNetworkManager::update();
+            RicCoreThread::delay(_loopDelay);
+        }
+        _onNetworkThread = false;
+    };
+
+    /**
+     * @brief Called by the network stack with a packet for a registered service
+     *
+     * @param serviceID
+     * @param packet
+     */
+    void receive(uint8_t serviceID, packetptr_t packet)
+    {
+        if (!_onNetworkThread)
+        {
+            dispatch(serviceID, std::move(packet));
+            return;
+        }
+        if (!_rxQueue.push(received_t{serviceID, std::move(packet)}))
+        {
+            ++_rxDropped;
+        }
+    };
+
+    void dispatch(uint8_t serviceID, packetptr_t packet)
+    {
+        auto service = _services.find(serviceID);
+        if (service != _services.end() && service->second)
+        {
+            service->second(std::move(packet));
+        }
+    };
+};
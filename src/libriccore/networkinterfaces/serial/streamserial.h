@@ -23,6 +23,7 @@
 #include <libriccore/riccorelogging.h>
 
 #include <libriccore/systemstatus/systemstatus.h>
+#include <libriccore/profiling/loopprofiler.h>
 
 #include "cobs.h"
 
@@ -83,9 +84,7 @@ public:
         if (encodedSize + _sendBuffer.size() > _info.sendBufferSize)
         {
             // not enough space
-            if (!_systemstatus.flagSet(SYSTEM_FLAGS_T::ERROR_SERIAL)){
-                _systemstatus.newFlag(SYSTEM_FLAGS_T::ERROR_SERIAL, "StreamSerial Send Buffer Overflow!");
-            }
+            _systemstatus.newFlag(SYSTEM_FLAGS_T::ERROR_SERIAL, "StreamSerial Send Buffer Overflow!");
             ++_info.txerror;
             return;
         }
@@ -110,6 +109,7 @@ public:
      */
     void update() override
     {
+        RICCORE_PROFILE_SCOPE("StreamSerial");
         checkSendBuffer();
         getPackets();
     };
@@ -0,0 +1,49 @@
+/**
+ * @file binarypacket.h
+ * @brief Generic rnp packet carrying an opaque byte payload. Used to send binary dumps (traces, stats, histories)
+ * produced by libriccore objects which provide a serialize(std::vector<uint8_t>&) method, without every object 
+ * needing its own packet definition.
+ */
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <librnp/rnp_packet.h>
+
+class BinaryPacket : public RnpPacket
+{
+public:
+    /**
+     * @brief Construct a new Binary Packet object
+     * 
+     * @param type packet type
+     * @param payload serialized payload, moved into the packet
+     */
+    BinaryPacket(uint8_t type, std::vector<uint8_t> payload) : RnpPacket(0, type, payload.size()),
+                                                               payload(std::move(payload)){};
+
+    /**
+     * @brief Construct a packet from any object providing serialize(std::vector<uint8_t>&)
+     * 
+     * @tparam SERIALIZABLE_T 
+     * @param type packet type
+     * @param object object to serialize into the payload
+     * @return BinaryPacket 
+     */
+    template <typename SERIALIZABLE_T>
+    static BinaryPacket fromSerializable(uint8_t type, const SERIALIZABLE_T &object)
+    {
+        std::vector<uint8_t> payload;
+        object.serialize(payload);
+        return BinaryPacket(type, std::move(payload));
+    };
+
+    void serialize(std::vector<uint8_t> &buf) override
+    {
+        RnpPacket::serialize(buf);
+        buf.insert(buf.end(), payload.begin(), payload.end());
+    };
+
+    std::vector<uint8_t> payload;
+};
@@ -7,9 +7,17 @@
  */
 
 #include <stdint.h>
+#include <cstddef>
+#include <array>
+#include <algorithm>
+#include <string>
+#include <stdexcept>
 #include <driver/adc.h>
 #include <esp_adc_cal.h>
 #include <esp32-hal-gpio.h>
+#include <soc/soc_caps.h>
+
+#include <libriccore/platform/millis.h>
 
 // ADC reference voltage = 1100mV, however, this can range between 1000mV and 1200mV.
 
@@ -65,4 +73,370 @@ private:
     static constexpr int VREF = 1100;
     uint16_t adc1_raw;
     uint16_t adc2_raw;
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Continuous ADC1 acquisition using the DMA (digital controller) mode of the driver. The configured channels
+ * are converted in a fixed pattern at a hardware timed rate into the driver's DMA ring buffer, so the sample rate and
+ * jitter no longer depend on the main loop and reads never block on a conversion. read() retrieves a batch of
+ * complete frames (one sample per channel, in pin order) and applies the esp_adc_cal calibration over the whole block,
+ * giving frame interleaved voltages which can be passed straight to RicCoreFiltering::FilterBankBase::updateBlock, or
+ * filtered in place with the update(bank) overload.
+ * Only ADC1 supports DMA on the esp32, and the one shot ADC wrapper must not be used on ADC1 while continuous mode
+ * is running. Only one ContinuousADC can be set up at a time as the digital controller is shared.
+ *
+ * @tparam N_CHANNELS number of ADC1 channels sampled
+ * @tparam BLOCK_FRAMES frames retrieved from the driver and calibrated per block
+ * @tparam BUFFER_FRAMES frames held by the driver's DMA ring buffer before samples are dropped
+ */
+template <size_t N_CHANNELS, size_t BLOCK_FRAMES = 64, size_t BUFFER_FRAMES = 512>
+class ContinuousADC
+{
+    static_assert(N_CHANNELS > 0 && N_CHANNELS <= SOC_ADC_PATT_LEN_MAX, "Too many continuous ADC channels!");
+    static_assert((BLOCK_FRAMES * N_CHANNELS * sizeof(adc_digi_output_data_t)) % 4 == 0, "ADC DMA block must be a multiple of 4 bytes!");
+    static_assert(BUFFER_FRAMES >= BLOCK_FRAMES, "ADC DMA ring buffer must hold at least one block!");
+
+public:
+    using frame_t = std::array<float, N_CHANNELS>;
+
+    /**
+     * @brief Construct a new Continuous ADC
+     *
+     * @param pins ADC1 capable pins, the frame order
+     * @param frameRate frames per second, each frame converts every channel once
+     * @param attenuation applied to every channel
+     */
+    ContinuousADC(const std::array<uint8_t, N_CHANNELS> &pins, uint32_t frameRate, adc_atten_t attenuation = ADC_ATTEN_DB_11) : _pins(pins),
+                                                                                                                                 _frameRate(frameRate),
+                                                                                                                                 _atten(attenuation),
+                                                                                                                                 _initialized(false),
+                                                                                                                                 _running(false),
+                                                                                                                                 _partial(),
+                                                                                                                                 _partialMask(0),
+                                                                                                                                 _latest(),
+                                                                                                                                 _drained(true),
+                                                                                                                                 _droppedFrames(0),
+                                                                                                                                 _overflows(0){};
+
+    ~ContinuousADC()
+    {
+        if (_initialized)
+        {
+            stop();
+            adc_digi_deinitialize();
+        }
+    };
+
+    /**
+     * @brief Configure the digital controller and calibration. Throws std::runtime_error if a pin is not an ADC1
+     * channel, a channel is repeated, the sample rate is out of the hardware range or the driver fails to initialize.
+     *
+     */
+    void setup()
+    {
+        std::array<adc_digi_pattern_config_t, N_CHANNELS> pattern{};
+        uint32_t channelMask = 0;
+        _slotOfChannel.fill(NO_SLOT);
+
+        for (size_t slot = 0; slot < N_CHANNELS; slot++)
+        {
+            const int8_t channel = digitalPinToAnalogChannel(_pins[slot]);
+            if (channel < 0 || channel >= ADC1_CHANNEL_MAX)
+            {
+                throw std::runtime_error("Pin " + std::to_string(_pins[slot]) + " is not an ADC1 channel!");
+            }
+            if (channelMask & (1u << channel))
+            {
+                throw std::runtime_error("Pin " + std::to_string(_pins[slot]) + " repeated in continuous ADC!");
+            }
+            channelMask |= (1u << channel);
+            _slotOfChannel[channel] = static_cast<uint8_t>(slot);
+
+            pattern[slot].atten = _atten;
+            pattern[slot].channel = static_cast<uint8_t>(channel);
+            pattern[slot].unit = 0; // ADC1
+            pattern[slot].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        }
+
+        const uint32_t sampleRate = _frameRate * N_CHANNELS;
+        if (sampleRate < SOC_ADC_SAMPLE_FREQ_THRES_LOW || sampleRate > SOC_ADC_SAMPLE_FREQ_THRES_HIGH)
+        {
+            throw std::runtime_error("Continuous ADC sample rate " + std::to_string(sampleRate) + "Hz out of range!");
+        }
+
+        adc_digi_init_config_t initConfig = {};
+        initConfig.max_store_buf_size = BUFFER_FRAMES * N_CHANNELS * sizeof(adc_digi_output_data_t);
+        initConfig.conv_num_each_intr = BLOCK_FRAMES * N_CHANNELS * sizeof(adc_digi_output_data_t);
+        initConfig.adc1_chan_mask = channelMask;
+        initConfig.adc2_chan_mask = 0;
+
+        esp_err_t err = adc_digi_initialize(&initConfig);
+        if (err != ESP_OK)
+        {
+            throw std::runtime_error("Continuous ADC failed to initialize with error code:" + std::to_string(static_cast<int>(err)));
+        }
+        _initialized = true;
+
+        adc_digi_configuration_t config = {};
+        config.conv_limit_en = true; // required on the esp32
+        config.conv_limit_num = 250;
+        config.pattern_num = N_CHANNELS;
+        config.adc_pattern = pattern.data();
+        config.sample_freq_hz = sampleRate;
+        config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+        config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+        err = adc_digi_controller_configure(&config);
+        if (err != ESP_OK)
+        {
+            throw std::runtime_error("Continuous ADC failed to configure with error code:" + std::to_string(static_cast<int>(err)));
+        }
+
+        // the esp32 calibration is linear unless the default vref is used at 11db where a lookup table applies
+        esp_adc_cal_characterize(ADC_UNIT_1, _atten, ADC_WIDTH_BIT_12, VREF, &_adcCal);
+        _gain = static_cast<float>(_adcCal.coeff_a) / 65536.f;
+        _offset = static_cast<float>(_adcCal.coeff_b);
+    };
+
+    void start()
+    {
+        if (_initialized && !_running)
+        {
+            adc_digi_start();
+            _running = true;
+        }
+    };
+
+    void stop()
+    {
+        if (_running)
+        {
+            adc_digi_stop();
+            _running = false;
+        }
+    };
+
+    /**
+     * @brief Retrieve up to maxFrames complete frames, calibrated to mV. Frames with a missing sample, e.g after the
+     * ring buffer overflowed, are discarded and counted.
+     *
+     * @param voltages output, maxFrames * N_CHANNELS frame interleaved voltages [mV]
+     * @param maxFrames
+     * @param timeout time to wait for the first frame [ms], 0 returns immediately
+     * @return size_t number of frames retrieved, fewer than maxFrames only if the driver had no more data
+     */
+    size_t read(float *voltages, size_t maxFrames, uint32_t timeout = 0)
+    {
+        if (!_running)
+        {
+            _drained = true;
+            return 0;
+        }
+
+        size_t framesRead = 0;
+        while (framesRead < maxFrames)
+        {
+            const size_t blockFrames = std::min(maxFrames - framesRead, BLOCK_FRAMES);
+            const size_t assembled = readBlock(blockFrames, framesRead == 0 ? timeout : 0);
+            if (_drained)
+            {
+                break;
+            }
+            if (assembled == 0)
+            {
+                // the driver returned only part of a frame (e.g at the ring buffer wrap), keep reading
+                continue;
+            }
+            calibrate(_rawBlock.data(), voltages + framesRead * N_CHANNELS, assembled * N_CHANNELS);
+            framesRead += assembled;
+            std::copy(voltages + (framesRead - 1) * N_CHANNELS, voltages + framesRead * N_CHANNELS, _latest.begin());
+        }
+        return framesRead;
+    };
+
+    /**
+     * @brief Drain every complete frame currently buffered through a filter bank, e.g
+     * RicCoreFiltering::MovingAverageBank<N_CHANNELS, 16>. The filtered output of the latest frame is then available
+     * from bank.get(). Reads until the driver reports no more data, or maxTime has passed so a high frame rate
+     * can't hold the caller indefinitely.
+     *
+     * @tparam BANK filter bank with N_CHANNELS float channels
+     * @param bank
+     * @param maxTime time after which no further blocks are read [us]
+     * @return size_t number of frames filtered
+     */
+    template <typename BANK>
+    size_t update(BANK &bank, uint32_t maxTime = 2000)
+    {
+        static_assert(BANK::channels() == N_CHANNELS, "Filter bank channel count must match the ADC!");
+
+        const uint32_t start = micros();
+        size_t framesFiltered = 0;
+        do
+        {
+            const size_t framesRead = read(_voltageBlock.data(), BLOCK_FRAMES);
+            bank.updateBlock(_voltageBlock.data(), _voltageBlock.data(), framesRead);
+            framesFiltered += framesRead;
+        } while (!_drained && micros() - start < maxTime);
+        return framesFiltered;
+    };
+
+    /**
+     * @brief Latest unfiltered frame returned by read [mV]
+     *
+     * @return const frame_t&
+     */
+    const frame_t &getLatest() const { return _latest; };
+
+    /**
+     * @brief Number of partially assembled frames discarded as a sample was lost. A frame whose first sample was
+     * lost is skipped without being counted.
+     *
+     * @return uint32_t
+     */
+    uint32_t getDroppedFrames() const { return _droppedFrames; };
+
+    /**
+     * @brief Number of reads which reported the driver ring buffer had overflowed, i.e samples were lost as the
+     * ring buffer wasn't drained fast enough
+     *
+     * @return uint32_t
+     */
+    uint32_t getOverflows() const { return _overflows; };
+
+    uint32_t getFrameRate() const { return _frameRate; };
+
+private:
+    static constexpr uint8_t NO_SLOT = UINT8_MAX;
+    static constexpr int VREF = 1100;
+
+    const std::array<uint8_t, N_CHANNELS> _pins;
+    const uint32_t _frameRate;
+    const adc_atten_t _atten;
+
+    bool _initialized;
+    bool _running;
+
+    esp_adc_cal_characteristics_t _adcCal;
+    float _gain;
+    float _offset;
+
+    /**
+     * @brief Frame slot of each ADC1 channel
+     *
+     */
+    std::array<uint8_t, ADC1_CHANNEL_MAX> _slotOfChannel;
+
+    std::array<adc_digi_output_data_t, BLOCK_FRAMES * N_CHANNELS> _dmaBlock;
+    std::array<uint16_t, BLOCK_FRAMES * N_CHANNELS> _rawBlock;
+    std::array<float, BLOCK_FRAMES * N_CHANNELS> _voltageBlock;
+
+    /**
+     * @brief Frame being assembled, carried between reads as a frame can span two DMA blocks
+     *
+     */
+    std::array<uint16_t, N_CHANNELS> _partial;
+    uint32_t _partialMask;
+
+    frame_t _latest;
+
+    /**
+     * @brief The last driver read returned no data
+     *
+     */
+    bool _drained;
+
+    uint32_t _droppedFrames;
+    uint32_t _overflows;
+
+    /**
+     * @brief Read at most maxFrames worth of samples from the driver and assemble them into complete raw frames
+     * in _rawBlock. Sets _drained if the driver had no data.
+     *
+     * @return size_t number of complete frames assembled
+     */
+    size_t readBlock(size_t maxFrames, uint32_t timeout)
+    {
+        uint32_t length = 0;
+        const esp_err_t err = adc_digi_read_bytes(reinterpret_cast<uint8_t *>(_dmaBlock.data()),
+                                                  maxFrames * N_CHANNELS * sizeof(adc_digi_output_data_t),
+                                                  &length,
+                                                  timeout);
+        if (err == ESP_ERR_INVALID_STATE)
+        {
+            // ring buffer overflowed, the data returned is still valid
+            ++_overflows;
+        }
+        else if (err != ESP_OK)
+        {
+            // ESP_ERR_TIMEOUT when the ring buffer is empty
+            _drained = true;
+            return 0;
+        }
+        _drained = (length == 0);
+
+        constexpr uint32_t completeMask = (1u << N_CHANNELS) - 1;
+        const size_t numSamples = length / sizeof(adc_digi_output_data_t);
+        size_t frames = 0;
+
+        for (size_t i = 0; i < numSamples; i++)
+        {
+            const adc_digi_output_data_t &sample = _dmaBlock[i];
+            const uint8_t channel = sample.type1.channel;
+            const uint8_t slot = (channel < ADC1_CHANNEL_MAX) ? _slotOfChannel[channel] : NO_SLOT;
+            if (slot == NO_SLOT)
+            {
+                continue;
+            }
+
+            // the pattern converts slots in order, so a slot arriving out of order means samples were lost. The
+            // incomplete frame is discarded and samples skipped until the next frame starts at slot 0
+            if (_partialMask != (1u << slot) - 1)
+            {
+                if (_partialMask != 0)
+                {
+                    ++_droppedFrames;
+                    _partialMask = 0;
+                }
+                if (slot != 0)
+                {
+                    continue;
+                }
+            }
+            _partial[slot] = sample.type1.data;
+            _partialMask |= (1u << slot);
+
+            if (_partialMask == completeMask)
+            {
+                std::copy(_partial.begin(), _partial.end(), _rawBlock.begin() + frames * N_CHANNELS);
+                ++frames;
+                _partialMask = 0;
+            }
+        }
+        return frames;
+    };
+
+    /**
+     * @brief Convert raw readings to mV. The linear characteristic is applied as a single multiply add per sample
+     * so the loop vectorises, falling back to the driver for the lookup table characteristic.
+     *
+     */
+    void calibrate(const uint16_t *__restrict raw, float *__restrict voltages, size_t count) const
+    {
+        if (_adcCal.low_curve != nullptr)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                voltages[i] = static_cast<float>(esp_adc_cal_raw_to_voltage(raw[i], &_adcCal));
+            }
+            return;
+        }
+
+        const float gain = _gain;
+        const float offset = _offset;
+        for (size_t i = 0; i < count; i++)
+        {
+            voltages[i] = gain * static_cast<float>(raw[i]) + offset;
+        }
+    };
+};
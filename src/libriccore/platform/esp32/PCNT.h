@@ -3,23 +3,75 @@
 /**
  * @file PCNT.h
  * @author Soham More
- * @brief PCNT wrapper for ESP32
+ * @brief PCNT wrapper for ESP32. The 16 bit hardware counter resets at COUNTER_LIMIT, the high limit watch point
+ * event is used to accumulate these overflows so the total count is 64 bit and never saturates. The overflow
+ * interrupt only increments an atomic counter, reading the total count and the frequency from the main loop takes
+ * no locks. The frequency is estimated over a configurable gate time using the monotonic timestamps of the count
+ * reads, so a late update lengthens the gate rather than biasing the estimate.
  * @date 2024
  */
 
 #include <stdint.h>
+#include <atomic>
+#include <string>
+#include <stdexcept>
 #include <driver/pcnt.h>
+#include <esp_attr.h>
+
+#include <libriccore/platform/millis.h>
 
 class PCNT{
 
 public:
 
+/**
+ * @brief Counts at which the hardware counter resets to 0, i.e the count accumulated per overflow event
+ *
+ */
+static constexpr int16_t COUNTER_LIMIT = 32767;
+
+/**
+ * @brief Both edges are counted so each input cycle adds 2 counts
+ *
+ */
+static constexpr uint8_t EDGES_PER_CYCLE = 2;
+
 PCNT(pcnt_unit_t _unit, pcnt_channel_t _channel, uint8_t _gpioSig):
 _unit(_unit),
 _channel(_channel),
-_gpioSig(_gpioSig)
+_gpioSig(_gpioSig),
+count(0),
+_overflows(0),
+_lastTotal(0),
+_gateTime(100000),
+_gateStartCount(0),
+_gateStartTime(0),
+_frequency(0),
+_handlerAdded(false)
 {};
 
+/**
+ * @brief Removes the overflow handler so the isr service never calls into a destroyed object
+ *
+ */
+~PCNT(){
+    if (_handlerAdded)
+    {
+        pcnt_isr_handler_remove(_unit);
+    }
+}
+
+// the overflow handler is registered with the address of this object, so it can't be copied or moved
+PCNT(const PCNT &) = delete;
+PCNT &operator=(const PCNT &) = delete;
+PCNT(PCNT &&) = delete;
+PCNT &operator=(PCNT &&) = delete;
+
+/**
+ * @brief Configure the unit and register the overflow event. Throws std::runtime_error if the overflow event
+ * can't be registered.
+ *
+ */
 void setup(){
         /* Prepare configuration for the PCNT unit */
         pcnt_config_t pcnt_config = {
@@ -27,8 +79,8 @@ void setup(){
             .pulse_gpio_num = _gpioSig,
             .ctrl_gpio_num = PCNT_PIN_NOT_USED,
             .pos_mode = PCNT_CHANNEL_EDGE_ACTION_INCREASE, // Count up on the positive edge
-            .neg_mode = PCNT_CHANNEL_EDGE_ACTION_INCREASE, // Keep the counter value on the negative edge
-            .counter_h_lim = 32767,
+            .neg_mode = PCNT_CHANNEL_EDGE_ACTION_INCREASE, // Count up on the negative edge
+            .counter_h_lim = COUNTER_LIMIT,
             .counter_l_lim = 0,
             .unit = _unit,
             .channel = _channel
@@ -39,23 +91,121 @@ void setup(){
         /* Initialize PCNT unit */
         pcnt_unit_config(&pcnt_config);
 
+        // Only the high limit event is used, the counter resets to 0 when it is reached
+        pcnt_event_disable(_unit, PCNT_EVT_L_LIM);
+        pcnt_event_disable(_unit, PCNT_EVT_ZERO);
+        pcnt_event_disable(_unit, PCNT_EVT_THRES_0);
+        pcnt_event_disable(_unit, PCNT_EVT_THRES_1);
+        pcnt_event_enable(_unit, PCNT_EVT_H_LIM);
+
+        // the isr service is shared between units so may already be installed
+        esp_err_t err = pcnt_isr_service_install(0);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE)
+        {
+            throw std::runtime_error("PCNT isr service failed to install with error code:" + std::to_string(static_cast<int>(err)));
+        }
+        if (_handlerAdded)
+        {
+            pcnt_isr_handler_remove(_unit);
+            _handlerAdded = false;
+        }
+        err = pcnt_isr_handler_add(_unit, overflowHandler, this);
+        if (err != ESP_OK)
+        {
+            throw std::runtime_error("PCNT overflow handler failed to register with error code:" + std::to_string(static_cast<int>(err)));
+        }
+        _handlerAdded = true;
+
         // Resetting count (PCNT bug)
         pcnt_counter_pause(_unit);
         pcnt_counter_clear(_unit);
+        _overflows.store(0);
+        _lastTotal = 0;
         pcnt_counter_resume(_unit);
-    
+
+        _gateStartCount = 0;
+        _gateStartTime = micros64();
+
 }
 
+/**
+ * @brief Read the counter, and update the frequency estimate once the gate time has elapsed
+ *
+ */
 void update(){
 
-    pcnt_get_counter_value(_unit, &count);
+    const uint64_t now = micros64();
+    const uint64_t total = getTotalCount();
+
+    const uint64_t elapsed = now - _gateStartTime;
+    if (elapsed >= _gateTime)
+    {
+        _frequency = static_cast<float>(total - _gateStartCount) * 1e6f / (static_cast<float>(elapsed) * EDGES_PER_CYCLE);
+        _gateStartCount = total;
+        _gateStartTime = now;
+    }
 
 }
+
+/**
+ * @brief Hardware counter value at the last update, wraps to 0 at COUNTER_LIMIT. Use getTotalCount for the
+ * accumulated count.
+ *
+ * @return esp_err_t
+ */
 esp_err_t getCount(){
 
     return count;
 }
 
+/**
+ * @brief Total number of counts (edges) since setup, including overflows. Lock free, but should only be called
+ * from a single thread (normally the main loop).
+ *
+ * @return uint64_t
+ */
+uint64_t getTotalCount(){
+
+    uint32_t overflows;
+    do
+    {
+        overflows = _overflows.load(std::memory_order_acquire);
+        pcnt_get_counter_value(_unit, &count);
+    } while (overflows != _overflows.load(std::memory_order_acquire)); // an overflow event ran during the read
+
+    uint64_t total = static_cast<uint64_t>(overflows) * COUNTER_LIMIT + static_cast<uint16_t>(count);
+
+    // the count only increases, so a smaller total means the counter has reset but the overflow event hasn't run
+    // yet (e.g it is pending on the other core)
+    if (total < _lastTotal)
+    {
+        total += COUNTER_LIMIT;
+    }
+    _lastTotal = total;
+    return total;
+}
+
+/**
+ * @brief Input frequency over the last complete gate time, 0 until the first gate time has elapsed
+ *
+ * @return float [Hz]
+ */
+float getFrequency(){
+
+    return _frequency;
+}
+
+/**
+ * @brief Set the gate time the frequency is measured over, longer gives more resolution at low frequency but a
+ * slower response. Takes effect from the next gate.
+ *
+ * @param gateTime [us]
+ */
+void setGateTime(uint32_t gateTime){
+
+    _gateTime = gateTime;
+}
+
  pcnt_unit_t _unit;
  pcnt_channel_t _channel;
  uint8_t _gpioSig;
@@ -63,7 +213,27 @@ esp_err_t getCount(){
 private:
 
     int16_t count;
-   
-    
 
-};
\ No newline at end of file
+    /**
+     * @brief Number of high limit events, written only by the overflow event handler
+     *
+     */
+    std::atomic<uint32_t> _overflows;
+
+    uint64_t _lastTotal;
+
+    uint32_t _gateTime; // [us]
+    uint64_t _gateStartCount;
+    uint64_t _gateStartTime; // [us]
+    float _frequency; // [Hz]
+
+    bool _handlerAdded;
+
+    static void IRAM_ATTR overflowHandler(void *arg){
+
+        static_cast<PCNT *>(arg)->_overflows.fetch_add(1, std::memory_order_release);
+    }
+
+
+
+};
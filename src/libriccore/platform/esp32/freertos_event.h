@@ -0,0 +1,50 @@
+#pragma once
+/**
+ * @file freertos_event.h
+ * @brief One shot event specialized for freertos using a statically allocated event group, interface must match
+ * Unix_Event
+ */
+#include <cstdint>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+class FreeRTOS_Event
+{
+    public:
+        FreeRTOS_Event():
+        eventGroupBuffer(),
+        eventGroup(xEventGroupCreateStatic(&eventGroupBuffer))
+        {};
+
+        ~FreeRTOS_Event()
+        {
+            vEventGroupDelete(eventGroup);
+        };
+
+        void set()
+        {
+            xEventGroupSetBits(eventGroup, setBit);
+        };
+
+        void wait()
+        {
+            xEventGroupWaitBits(eventGroup, setBit, pdFALSE, pdTRUE, portMAX_DELAY); //block until set, leaving the bit set
+        };
+
+        bool wait(uint32_t timeout)
+        {
+            return xEventGroupWaitBits(eventGroup, setBit, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout)) & setBit;
+        };
+
+        bool isSet()
+        {
+            return xEventGroupGetBits(eventGroup) & setBit;
+        };
+
+    private:
+        static constexpr EventBits_t setBit = 1;
+
+        StaticEventGroup_t eventGroupBuffer;
+        EventGroupHandle_t eventGroup;
+};
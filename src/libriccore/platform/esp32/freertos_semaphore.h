@@ -0,0 +1,39 @@
+#pragma once
+/**
+ * @file freertos_semaphore.h
+ * @brief Counting semaphore specialized for freertos, interface must match Unix_Semaphore
+ */
+#include <cstdint>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+class FreeRTOS_Semaphore
+{
+    public:
+        FreeRTOS_Semaphore(uint32_t initialCount = 0):
+        semaphoreBuffer(),
+        semaphore(xSemaphoreCreateCountingStatic(maxCount, initialCount, &semaphoreBuffer))
+        {};
+
+        void give()
+        {
+            xSemaphoreGive(semaphore);
+        };
+
+        void take()
+        {
+            xSemaphoreTake(semaphore, portMAX_DELAY); //block until the count is non zero
+        };
+
+        bool take(uint32_t timeout)
+        {
+            return xSemaphoreTake(semaphore, pdMS_TO_TICKS(timeout)) == pdTRUE;
+        };
+
+    private:
+        static constexpr UBaseType_t maxCount = 0x7FFFFFFF;
+
+        StaticSemaphore_t semaphoreBuffer;
+        SemaphoreHandle_t semaphore;
+};
@@ -1,2 +1,24 @@
 #pragma once
-#include <Arduino.h> //millis contained in arduino, but can override with custom impl
\ No newline at end of file
+#include <Arduino.h> //millis and micros contained in arduino, but can override with custom impl
+#include <esp_timer.h>
+
+#include <cstdint>
+
+/**
+ * @brief Monotonic microsecond counter since boot from the esp timer, doesn't wrap. Prefer this over micros() for
+ * timestamps.
+ * 
+ * @return uint64_t 
+ */
+inline uint64_t micros64(){
+    return static_cast<uint64_t>(esp_timer_get_time());
+};
+
+/**
+ * @brief Monotonic nanosecond counter since boot. The esp timer only has microsecond resolution.
+ * 
+ * @return uint64_t 
+ */
+inline uint64_t nanos(){
+    return micros64() * 1000;
+};
@@ -5,6 +5,8 @@
 #include <memory>
 #include <functional>
 #include <atomic>
+#include <algorithm>
+#include <stdexcept>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -12,12 +14,13 @@
 
 // #include <esp_pthread.h>
 
-// TODO: convert this to static task generation 
+// static task generation is provided by StaticThread
 //TODO : add thread terminate 
 
 
 RicCoreThread::Thread::Thread(std::function<void(void*)> f_ptr, void* args,const size_t stack_size,const int priority,const CORE_ID coreID, std::string_view name):
-deleted(true)
+deleted(true),
+completion(std::make_shared<Event_t>())
 {
     if (coreID > CORE_ID::ANYCORE)
     {
@@ -31,25 +34,35 @@ deleted(true)
         std::function<void(void*)> taskCode;
         void* args;
         std::atomic<bool> *deleted;
+        std::shared_ptr<Event_t> completion;
     };
 
-    TaskArgs* wrapped_f_args = new TaskArgs{f_ptr,args,&deleted};
+    TaskArgs* wrapped_f_args = new TaskArgs{f_ptr,args,&deleted,completion};
     //construct lambda wrapper to include deleter at the return of f_ptr
     auto wrapped_f_ptr = [](void *args){
-                                            TaskArgs taskArgs;
-                                            if (args != nullptr)
                                             {
-                                                //copy task args to scoped variable
-                                                taskArgs = *reinterpret_cast<TaskArgs*>(args); 
-                                                //delete args as we have copied to scoped local variable
-                                                delete reinterpret_cast<TaskArgs*>(args);
-                                                taskArgs.taskCode(taskArgs.args);
-                                            }
-
-                                            if (taskArgs.deleted != nullptr)
-                                            {
-                                                taskArgs.deleted->store(true);
-                                            }
+                                                TaskArgs taskArgs;
+                                                if (args != nullptr)
+                                                {
+                                                    //copy task args to scoped variable
+                                                    taskArgs = *reinterpret_cast<TaskArgs*>(args); 
+                                                    //delete args as we have copied to scoped local variable
+                                                    delete reinterpret_cast<TaskArgs*>(args);
+                                                    taskArgs.taskCode(taskArgs.args);
+                                                }
+
+                                                if (taskArgs.deleted != nullptr)
+                                                {
+                                                    taskArgs.deleted->store(true);
+                                                }
+
+                                                // wakes the joiner, which may destroy the Thread straight away. Our
+                                                // copy of completion keeps the event group alive until set returns
+                                                if (taskArgs.completion)
+                                                {
+                                                    taskArgs.completion->set();
+                                                }
+                                            } // release the task args before deleting, vTaskDelete doesn't return
 
                                             vTaskDelete(nullptr); //deletes the current running task
 
@@ -93,13 +106,82 @@ RicCoreThread::Thread::~Thread() {
 
 void RicCoreThread::Thread::join()
 {
+    // blocks on the completion event group rather than polling the task state
+    completion->wait();
+}
+
+bool RicCoreThread::Thread::join(uint32_t timeout)
+{
+    return completion->wait(timeout);
+}
+
+
+RicCoreThread::StaticThreadBase::StaticThreadBase(taskFunction_t f_ptr, void* args, Stack_t* stack, const size_t stack_size, TaskBuffer_t* taskBuffer, const int priority, const Thread::CORE_ID coreID, std::string_view name):
+taskCode(f_ptr),
+taskArgs(args),
+handle(nullptr),
+completion()
+{
+    if (coreID > Thread::CORE_ID::ANYCORE)
+    {
+        throw std::runtime_error("Illegal core id given!");
+    }
+
+    // copy the name onto the stack, a string_view isn't null terminated and std::string may allocate
+    char taskName[configMAX_TASK_NAME_LEN];
+    const size_t nameLength = std::min(name.size(), sizeof(taskName) - 1);
+    std::copy_n(name.data(), nameLength, taskName);
+    taskName[nameLength] = '\0';
+
+    const BaseType_t core = (coreID == Thread::CORE_ID::ANYCORE) ? tskNO_AFFINITY : static_cast<BaseType_t>(coreID);
+
+    // stack depth is given in bytes on the esp32
+    handle = xTaskCreateStaticPinnedToCore(taskEntry, taskName, stack_size, this, priority, stack, taskBuffer, core);
+
+    if (handle == nullptr)
+    {
+        throw std::runtime_error("Static thread failed to start!");
+    }
+}
+
+RicCoreThread::StaticThreadBase::~StaticThreadBase()
+{
+    join();
 
-    //if the task handle is not null (i.e still exists) OR the state of the task is not deleted (i.e is still running or blocked),
-    // block the callee of this function until the thread of interest is non-existant
-    while((handle != nullptr) && (eTaskGetState(handle) != eTaskState::eDeleted) && (!deleted))
+    // wait for the task to suspend itself after setting completion, so it isn't running when deleted. Deleting a task
+    // which isn't running frees it immediately, so the stack and control block aren't referenced afterwards. Block
+    // rather than yield between checks, taskYIELD only gives way to tasks of the same priority so a higher priority
+    // caller would never let the task reach vTaskSuspend
+    while (eTaskGetState(handle) != eSuspended)
     {
-        block();
+        vTaskDelay(1);
     }
+    vTaskDelete(handle);
+}
+
+void RicCoreThread::StaticThreadBase::join()
+{
+    completion.wait();
+}
+
+bool RicCoreThread::StaticThreadBase::join(uint32_t timeout)
+{
+    return completion.wait(timeout);
+}
+
+void RicCoreThread::StaticThreadBase::taskEntry(void* arg)
+{
+    StaticThreadBase* thread = static_cast<StaticThreadBase*>(arg);
+    thread->taskCode(thread->taskArgs);
+
+    // setting completion wakes the joiner straight away, and a joiner of higher priority would pre-empt this task
+    // before it suspends, leaving the destructor to wait a tick per check. Raising the priority first lets the task
+    // reach vTaskSuspend before the joiner runs on this core
+    vTaskPrioritySet(nullptr, configMAX_PRIORITIES - 1);
+    thread->completion.set();
+
+    // the owner deletes the task, a static task deleting itself would leave its buffers queued for the idle task
+    vTaskSuspend(nullptr);
 }
 
 
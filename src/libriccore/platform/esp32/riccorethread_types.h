@@ -15,12 +15,22 @@
 #include <freertos/task.h>
 
 #include "freertos_lock.h"
+#include "freertos_semaphore.h"
+#include "freertos_event.h"
 
 // This file is used to specify base types for general headers
 namespace RicCoreThread
 {
     using ThreadHandle_t = TaskHandle_t;
 
+    using Stack_t = StackType_t;
+
+    using TaskBuffer_t = StaticTask_t;
+
     using Lock_t = FreeRTOS_Lock;
 
+    using Semaphore_t = FreeRTOS_Semaphore;
+
+    using Event_t = FreeRTOS_Event;
+
 };
\ No newline at end of file
@@ -1,8 +1,42 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
 
+/**
+ * @brief Monotonic nanosecond counter since an arbitrary epoch, backed by steady_clock so it never jumps with
+ * system time adjustments.
+ * 
+ * @return uint64_t 
+ */
+inline uint64_t nanos(){
+    auto duration = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+};
+
+/**
+ * @brief Monotonic microsecond counter, doesn't wrap. Prefer this over micros() for timestamps.
+ * 
+ * @return uint64_t 
+ */
+inline uint64_t micros64(){
+    auto duration = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+};
+
+/**
+ * @brief Millisecond counter matching the arduino millis() signature, monotonic and wraps like the arduino implementation.
+ * 
+ * @return uint32_t 
+ */
 inline uint32_t millis(){
-    auto duration = std::chrono::system_clock::now().time_since_epoch();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
-    return uint32_t(ms);
-};
\ No newline at end of file
+    return uint32_t(micros64() / 1000);
+};
+
+/**
+ * @brief Microsecond counter matching the arduino micros() signature, wraps like the arduino implementation.
+ * 
+ * @return uint32_t 
+ */
+inline uint32_t micros(){
+    return uint32_t(micros64());
+};
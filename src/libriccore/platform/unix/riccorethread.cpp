@@ -1,7 +1,14 @@
 /**
  * @file riccorethread.cpp
  * @author Kiran de Silva (kd619@ic.ac.uk)
- * @brief Contains implementation specific to unix platform for riccorethread
+ * @brief Contains implementation specific to unix platform for riccorethread. Threads are created with pthreads
+ * directly so the stack size, core affinity, priority and name given to RicCoreThread::Thread are honoured like on the
+ * esp32. Core affinity is set at creation, CORE0 and CORE1 map to cpu 0 and 1 and are ignored if that cpu isn't
+ * available to the process. Priorities above 0 are mapped to a nice value of -priority (capped at -20), keeping the
+ * default time shared scheduling, so a thread which busy waits (e.g a flush loop calling block()) can't starve the
+ * rest of its cpu. Priorities of at least LIBRICCORE_UNIX_RT_PRIORITY, if that is set above 0, are mapped to
+ * SCHED_FIFO with the same priority value instead, falling back to the nice value without realtime privileges. The
+ * default scheduling is kept if the process lacks the privileges for either.
  * @version 0.1
  * @date 2023-08-14
  *
@@ -16,17 +23,144 @@
 #include <mutex>
 #include <memory>
 #include <functional>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
 
-RicCoreThread::Thread::Thread(std::function<void(void *)> f_ptr, void *args, const size_t stack_size, const int priority, const CORE_ID coreID, std::string_view name)
+#include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/resource.h>
+
+namespace
 {
+    struct ThreadStart
+    {
+        std::function<void(void *)> taskCode;
+        void *args;
+        int priority;
+        std::string name;
+        std::shared_ptr<RicCoreThread::Event_t> completion; // set when taskCode returns, may be null
+    };
+
+    /**
+     * @brief Map a RicCoreThread priority onto linux scheduling for the calling thread
+     *
+     * @param priority
+     */
+    void applyPriority(int priority)
+    {
+        if (priority <= 0)
+        {
+            return;
+        }
+
+        if (LIBRICCORE_UNIX_RT_PRIORITY <= 0 || priority < LIBRICCORE_UNIX_RT_PRIORITY)
+        {
+            // Linux applies nice per thread so 0 is the calling thread
+            setpriority(PRIO_PROCESS, 0, -std::min(priority, 20));
+            return;
+        }
+
+        sched_param param{};
+        param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+        {
+            return;
+        }
 
-    if (coreID > CORE_ID::ANYCORE)
+        // no realtime privileges, try raising the nice value instead. Without privileges this also fails and the
+        // default scheduling is kept
+        setpriority(PRIO_PROCESS, 0, -std::min(priority, 20));
+    }
+
+    void *threadEntry(void *arg)
     {
-        throw std::runtime_error("Illegal Core specified!");
+        std::unique_ptr<ThreadStart> start(static_cast<ThreadStart *>(arg));
+
+        if (!start->name.empty())
+        {
+            // linux limits thread names to 15 characters
+            pthread_setname_np(pthread_self(), start->name.substr(0, 15).c_str());
+        }
+        applyPriority(start->priority);
+
+        start->taskCode(start->args);
+        if (start->completion)
+        {
+            start->completion->set();
+        }
+        return nullptr;
     }
 
-    std::thread thread(f_ptr, args);
-    handle = std::move(thread);
+    /**
+     * @brief Create a pthread applying the RicCoreThread stack size and core affinity, takes ownership of start
+     *
+     * @param handle
+     * @param start
+     * @param stack_size [bytes], 0 for the default
+     * @param coreID
+     * @param stack caller owned stack of stack_size bytes, nullptr to let pthreads allocate the stack
+     */
+    void createThread(pthread_t &handle, ThreadStart *start, size_t stack_size, RicCoreThread::Thread::CORE_ID coreID, void *stack)
+    {
+        if (coreID > RicCoreThread::Thread::CORE_ID::ANYCORE)
+        {
+            delete start;
+            throw std::runtime_error("Illegal Core specified!");
+        }
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+
+        if (stack != nullptr && stack_size >= static_cast<size_t>(PTHREAD_STACK_MIN))
+        {
+            pthread_attr_setstack(&attr, stack, stack_size);
+        }
+        else if (stack_size)
+        {
+            pthread_attr_setstacksize(&attr, std::max<size_t>(stack_size, PTHREAD_STACK_MIN));
+        }
+
+        if (coreID != RicCoreThread::Thread::CORE_ID::ANYCORE)
+        {
+            const int cpu = static_cast<int>(coreID);
+            cpu_set_t available;
+            CPU_ZERO(&available);
+            sched_getaffinity(0, sizeof(available), &available);
+            if (CPU_ISSET(cpu, &available))
+            {
+                cpu_set_t cpuset;
+                CPU_ZERO(&cpuset);
+                CPU_SET(cpu, &cpuset);
+                pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+            }
+        }
+
+        int result = pthread_create(&handle, &attr, threadEntry, start);
+        if (result != 0 && stack != nullptr)
+        {
+            // the caller owned stack may be rejected (e.g alignment or under sanitizers), fall back to allocating
+            pthread_attr_destroy(&attr);
+            return createThread(handle, start, stack_size, coreID, nullptr);
+        }
+        pthread_attr_destroy(&attr);
+
+        if (result != 0)
+        {
+            delete start;
+            throw std::runtime_error("Thread failed to start with error code:" + std::to_string(result));
+        }
+    }
+};
+
+RicCoreThread::Thread::Thread(std::function<void(void *)> f_ptr, void *args, const size_t stack_size, const int priority, const CORE_ID coreID, std::string_view name):
+deleted(true),
+completion(std::make_shared<Event_t>())
+{
+
+    createThread(handle, new ThreadStart{f_ptr, args, priority, std::string(name), completion}, stack_size, coreID, nullptr);
+    deleted = false;
     success = true;
 }
 
@@ -37,7 +171,55 @@ RicCoreThread::Thread::~Thread()
 
 void RicCoreThread::Thread::join()
 {
-    handle.join();
+    completion->wait();
+
+    // deleted marks the thread as already joined, as a pthread can only be joined once
+    if (!deleted.exchange(true))
+    {
+        pthread_join(handle, nullptr);
+    }
+}
+
+bool RicCoreThread::Thread::join(uint32_t timeout)
+{
+    if (!completion->wait(timeout))
+    {
+        return false;
+    }
+    join();
+    return true;
+}
+
+
+RicCoreThread::StaticThreadBase::StaticThreadBase(taskFunction_t f_ptr, void *args, Stack_t *stack, const size_t stack_size, TaskBuffer_t *, const int priority, const Thread::CORE_ID coreID, std::string_view name):
+taskCode(f_ptr),
+taskArgs(args),
+completion()
+{
+    createThread(handle, new ThreadStart{taskEntry, this, priority, std::string(name), nullptr}, stack_size, coreID, stack);
+}
+
+RicCoreThread::StaticThreadBase::~StaticThreadBase()
+{
+    join();
+    pthread_join(handle, nullptr);
+}
+
+void RicCoreThread::StaticThreadBase::join()
+{
+    completion.wait();
+}
+
+bool RicCoreThread::StaticThreadBase::join(uint32_t timeout)
+{
+    return completion.wait(timeout);
+}
+
+void RicCoreThread::StaticThreadBase::taskEntry(void *arg)
+{
+    StaticThreadBase *thread = static_cast<StaticThreadBase *>(arg);
+    thread->taskCode(thread->taskArgs);
+    thread->completion.set();
 }
 
 
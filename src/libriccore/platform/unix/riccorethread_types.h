@@ -10,18 +10,45 @@
  * 
  */
 #include <thread>
+#include <pthread.h>
 #include <mutex>
 #include <queue>
 #include <atomic>
+#include <cstdint>
 
 
 #include "unix_lock.h"
+#include "unix_semaphore.h"
+#include "unix_event.h"
+
+/**
+ * @brief Lowest RicCoreThread priority run with SCHED_FIFO, lower priorities above 0 only lower the nice value.
+ * 0 (the default) never uses SCHED_FIFO. Set with the LIBRICCORE_UNIX_RT_PRIORITY cmake cache variable.
+ *
+ */
+#ifndef LIBRICCORE_UNIX_RT_PRIORITY
+#define LIBRICCORE_UNIX_RT_PRIORITY 0
+#endif
 
 // This file is used to specify base types for general headers
 namespace RicCoreThread
 {
-    using ThreadHandle_t = std::thread;
+    using ThreadHandle_t = pthread_t;
+
+    using Stack_t = uint8_t;
+
+    /**
+     * @brief No separate task control block is needed by pthreads
+     *
+     */
+    struct TaskBuffer_t
+    {
+    };
 
     using Lock_t = Unix_Lock;
 
+    using Semaphore_t = Unix_Semaphore;
+
+    using Event_t = Unix_Event;
+
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+/**
+ * @file unix_event.h
+ * @brief One shot event, once set it stays set and every waiter is released. Interface must match FreeRTOS_Event
+ */
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+class Unix_Event
+{
+public:
+    Unix_Event() : flag(false){};
+
+    void set()
+    {
+        // notify while holding the lock so a released waiter can't destroy the event before notify returns
+        std::lock_guard<std::mutex> l(lock);
+        flag = true;
+        cv.notify_all();
+    };
+
+    /**
+     * @brief Block until the event is set
+     *
+     */
+    void wait()
+    {
+        std::unique_lock<std::mutex> l(lock);
+        cv.wait(l, [this]()
+                { return flag; });
+    };
+
+    /**
+     * @brief Block until the event is set or the timeout expires
+     *
+     * @param timeout [ms]
+     * @return true the event is set
+     * @return false timed out
+     */
+    bool wait(uint32_t timeout)
+    {
+        std::unique_lock<std::mutex> l(lock);
+        return cv.wait_for(l, std::chrono::milliseconds(timeout), [this]()
+                           { return flag; });
+    };
+
+    bool isSet()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return flag;
+    };
+
+private:
+    std::mutex lock;
+    std::condition_variable cv;
+    bool flag;
+};
@@ -0,0 +1,64 @@
+#pragma once
+/**
+ * @file unix_semaphore.h
+ * @brief Counting semaphore, interface must match FreeRTOS_Semaphore
+ */
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+class Unix_Semaphore
+{
+public:
+    Unix_Semaphore(uint32_t initialCount = 0) : count(initialCount){};
+
+    /**
+     * @brief Increment the count, waking a waiting thread
+     *
+     */
+    void give()
+    {
+        {
+            std::lock_guard<std::mutex> l(lock);
+            ++count;
+        }
+        cv.notify_one();
+    };
+
+    /**
+     * @brief Block until the count is non zero then decrement it
+     *
+     */
+    void take()
+    {
+        std::unique_lock<std::mutex> l(lock);
+        cv.wait(l, [this]()
+                { return count > 0; });
+        --count;
+    };
+
+    /**
+     * @brief Block until the count is non zero or the timeout expires
+     *
+     * @param timeout [ms]
+     * @return true the count was decremented
+     * @return false timed out
+     */
+    bool take(uint32_t timeout)
+    {
+        std::unique_lock<std::mutex> l(lock);
+        if (!cv.wait_for(l, std::chrono::milliseconds(timeout), [this]()
+                         { return count > 0; }))
+        {
+            return false;
+        }
+        --count;
+        return true;
+    };
+
+private:
+    std::mutex lock;
+    std::condition_variable cv;
+    uint32_t count;
+};
@@ -0,0 +1,264 @@
+#pragma once
+/**
+ * @file loopprofiler.h
+ * @brief Opt-in main loop instrumentation. RICCORE_PROFILE_SCOPE("name") times the rest of the enclosing scope with
+ * micros() and records it into the named section of the global profiler, giving min, mean, max and p99 per section in
+ * fixed memory. The core system update loop and the default network interfaces are already instrumented.
+ * Profiling is compiled out unless LIBRICCORE_PROFILING is defined (the LIBRICCORE_PROFILING cmake option), in which
+ * case the macro expands to nothing. The stats can be dumped on demand to the SYS logger with
+ * RicCoreProfiling::getProfiler().log() or sent over rnp with
+ * BinaryPacket::fromSerializable(type, RicCoreProfiling::getProfiler()).
+ * Sections can be recorded from any thread (e.g the network thread of the PipelinedNetworkManager). Recording,
+ * reading and resetting all take the profiler lock, so the stats can be read from one thread while others record.
+ * Readers work on a snapshot taken under the lock and never log while holding it.
+ */
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <string>
+#include <optional>
+
+#include <libriccore/platform/millis.h>
+#include <libriccore/util/durationstats.h>
+#include <libriccore/riccorelogging.h>
+#include <libriccore/threading/scopedlock.h>
+
+template <size_t N_MAX_SECTIONS = 16>
+class LoopProfiler
+{
+public:
+    /**
+     * @brief Length of section names in the serialized output, longer names are truncated
+     *
+     */
+    static constexpr size_t NAME_LENGTH = 16;
+
+    struct section_t
+    {
+        const char *name;
+        RicCoreUtil::DurationStats stats;
+    };
+
+    /**
+     * @brief Times its lifetime and records it into a section of the profiler. A nullptr section is ignored.
+     *
+     */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(LoopProfiler &profiler, section_t *section) : _profiler(profiler),
+                                                                  _section(section),
+                                                                  _start(micros()){};
+
+        ~ScopedTimer()
+        {
+            if (_section != nullptr)
+            {
+                _profiler.record(*_section, micros() - _start);
+            }
+        };
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        LoopProfiler &_profiler;
+        section_t *const _section;
+        const uint32_t _start;
+    };
+
+    LoopProfiler() : _sections(),
+                     _numSections(0){};
+
+    /**
+     * @brief Find the section with the given name, creating it if it doesn't exist. The name is not copied so
+     * must outlive the profiler, e.g a string literal.
+     *
+     * @param name
+     * @return section_t* nullptr if the maximum number of sections has been reached
+     */
+    section_t *getSection(const char *name)
+    {
+        RicCoreThread::ScopedLock sl(_sectionLock);
+        for (size_t i = 0; i < _numSections; i++)
+        {
+            if (_sections[i].name == name || std::strcmp(_sections[i].name, name) == 0)
+            {
+                return &_sections[i];
+            }
+        }
+
+        if (_numSections == N_MAX_SECTIONS)
+        {
+            return nullptr;
+        }
+
+        section_t &section = _sections[_numSections++];
+        section.name = name;
+        section.stats.reset();
+        return &section;
+    };
+
+    /**
+     * @brief Get a snapshot of the stats of a section
+     *
+     * @param name
+     * @return std::optional<RicCoreUtil::DurationStats> empty if the section doesn't exist
+     */
+    std::optional<RicCoreUtil::DurationStats> getStats(const char *name) const
+    {
+        RicCoreThread::ScopedLock sl(_sectionLock);
+        for (size_t i = 0; i < _numSections; i++)
+        {
+            if (std::strcmp(_sections[i].name, name) == 0)
+            {
+                return _sections[i].stats;
+            }
+        }
+        return std::nullopt;
+    };
+
+    size_t getNumSections() const
+    {
+        RicCoreThread::ScopedLock sl(_sectionLock);
+        return _numSections;
+    };
+
+    /**
+     * @brief Log a summary line per section to the given logger
+     *
+     * @tparam LOGGING_TARGET
+     */
+    template <RicCoreLoggingConfig::LOGGERS LOGGING_TARGET = RicCoreLoggingConfig::LOGGERS::SYS>
+    void log() const
+    {
+        std::array<section_summary_t, N_MAX_SECTIONS> summaries;
+        const size_t numSections = snapshot(summaries);
+        for (size_t i = 0; i < numSections; i++)
+        {
+            const RicCoreUtil::DurationStats::summary_t &summary = summaries[i].summary;
+            RicCoreLogging::log<LOGGING_TARGET>(std::string(summaries[i].name) +
+                                                " n:" + std::to_string(summary.count) +
+                                                " min:" + std::to_string(summary.min) +
+                                                " mean:" + std::to_string(summary.mean) +
+                                                " p99:" + std::to_string(summary.p99) +
+                                                " max:" + std::to_string(summary.max) + "us");
+        }
+    };
+
+    /**
+     * @brief Serializes a summary of every section.
+     * Format: uint32 section count, {char name[NAME_LENGTH] null padded, DurationStats::summary_t}[count]
+     *
+     * @param buf buffer to append to
+     */
+    void serialize(std::vector<uint8_t> &buf) const
+    {
+        std::array<section_summary_t, N_MAX_SECTIONS> summaries;
+        const size_t numSections = snapshot(summaries);
+        appendBytes(buf, static_cast<uint32_t>(numSections));
+        for (size_t i = 0; i < numSections; i++)
+        {
+            std::array<char, NAME_LENGTH> name{};
+            std::strncpy(name.data(), summaries[i].name, NAME_LENGTH);
+            appendBytes(buf, name);
+            appendBytes(buf, summaries[i].summary);
+        }
+    };
+
+    /**
+     * @brief Reset the stats of every section, sections are kept
+     *
+     */
+    void resetStats()
+    {
+        RicCoreThread::ScopedLock sl(_sectionLock);
+        for (size_t i = 0; i < _numSections; i++)
+        {
+            _sections[i].stats.reset();
+        }
+    };
+
+private:
+    std::array<section_t, N_MAX_SECTIONS> _sections;
+    size_t _numSections;
+
+    /**
+     * @brief Guards the section table and the stats of every section
+     *
+     */
+    mutable RicCoreThread::Lock_t _sectionLock;
+
+    struct section_summary_t
+    {
+        const char *name;
+        RicCoreUtil::DurationStats::summary_t summary;
+    };
+
+    void record(section_t &section, uint32_t duration)
+    {
+        RicCoreThread::ScopedLock sl(_sectionLock);
+        section.stats.record(duration);
+    };
+
+    /**
+     * @brief Copy the name and summary of every section under the lock
+     *
+     * @return size_t number of sections copied
+     */
+    size_t snapshot(std::array<section_summary_t, N_MAX_SECTIONS> &summaries) const
+    {
+        RicCoreThread::ScopedLock sl(_sectionLock);
+        for (size_t i = 0; i < _numSections; i++)
+        {
+            summaries[i] = section_summary_t{_sections[i].name, _sections[i].stats.summary()};
+        }
+        return _numSections;
+    };
+
+    template <typename T>
+    static void appendBytes(std::vector<uint8_t> &buf, const T &value)
+    {
+        const size_t offset = buf.size();
+        buf.resize(offset + sizeof(T));
+        std::memcpy(buf.data() + offset, &value, sizeof(T));
+    };
+};
+
+struct RicCoreProfiling
+{
+    using profiler_t = LoopProfiler<>;
+
+    /**
+     * @brief Global profiler used by RICCORE_PROFILE_SCOPE
+     *
+     * @return profiler_t&
+     */
+    static profiler_t &getProfiler()
+    {
+        static profiler_t profiler;
+        return profiler;
+    };
+};
+
+#define RICCORE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define RICCORE_PROFILE_CONCAT(a, b) RICCORE_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef LIBRICCORE_PROFILING
+/**
+ * @brief Time the rest of the enclosing scope into the named section. The section is looked up once per call site,
+ * so the name must be constant for a given call site.
+ *
+ */
+#define RICCORE_PROFILE_SCOPE(name)                                                                                       \
+    static RicCoreProfiling::profiler_t::section_t *const RICCORE_PROFILE_CONCAT(_riccoreProfileSection, __LINE__) =     \
+        RicCoreProfiling::getProfiler().getSection(name);                                                                 \
+    const RicCoreProfiling::profiler_t::ScopedTimer RICCORE_PROFILE_CONCAT(_riccoreProfileTimer, __LINE__)(            \
+        RicCoreProfiling::getProfiler(), RICCORE_PROFILE_CONCAT(_riccoreProfileSection, __LINE__))
+#else
+#define RICCORE_PROFILE_SCOPE(name) \
+    do                              \
+    {                               \
+    } while (0)
+#endif
@@ -15,6 +15,7 @@ struct RicCoreLogging{
      * inside a lambda e.g:
      * [](std::string_view msg){RicCoreLogging::log<RicCoreLoggingConfig::LOGGERS::SYS>(msg);};
      * as direct auto aliasing of this function is not currently possible.
+     * Safe to call from any thread, the call holds the logger handler lock while the loggers run.
      * 
      * @tparam logger_names name of loggers to log to 
      * @tparam Ts types of the function arguments 
@@ -22,6 +23,7 @@ struct RicCoreLogging{
      */
     template<RicCoreLoggingConfig::LOGGERS... logger_names,class... Ts> // maybe add an assert here to check LOGGER contains NAME for nicer debug message
     static void log(Ts&&... args){
+        LoggerHandler::LogGuard lg(LoggerHandler::getInstance());
         ((LoggerHandler::getInstance().retrieve_logger<logger_names>().log(std::forward<Ts>(args)...)), ...);
         };
 
@@ -7,12 +7,18 @@
 #include <librnp/rnp_nvs_save.h>
 
 #include "networkinterfaces/serial/streamserial.h"
+#include "networkinterfaces/pipelinednetworkmanager.h"
 
 #include "fsm/statemachine.h"
 
 #include "systemstatus/systemstatus.h"
 
 #include "commands/commandhandler.h"
+#include "commands/staticcommandhandler.h"
+
+#include "scheduling/taskscheduler.h"
+
+#include "profiling/loopprofiler.h"
 
 #include "logging/loggerhandler.h"
 #include "logging/iloggerhandler.h"
@@ -27,15 +33,29 @@
 #include <esp_ota_ops.h>
 #endif
 
+/**
+ * @brief Core system class, the derived system inherits from this.
+ *
+ * @tparam DERIVED type of the derived system
+ * @tparam SYSTEM_FLAGS_T Enum of system flags
+ * @tparam COMMAND_ID_ENUM Enum of command ids
+ * @tparam COMMAND_TABLE Optional compile time CommandTable. If void, commands are registered at runtime with a
+ * command map, otherwise the StaticCommandHandler is used and the command map constructor is not available.
+ */
 template<typename DERIVED,
          typename SYSTEM_FLAGS_T,
-         typename COMMAND_ID_ENUM>
+         typename COMMAND_ID_ENUM,
+         typename COMMAND_TABLE = void>
 class RicCoreSystem{
     //checks if derived class is hiding main update loop
     // static_assert(!RicCoreUtil::is_detected<decltype(DERIVED::coreSystemUpdate), DERIVED>::value, "Dervied System re-implements underlying update function!");
     // static_assert(!RicCoreUtil::is_detected<decltype(DERIVED::coreSystemSetup), DERIVED>::value, "Dervied System re-implements underlying setup loop!");  
 
     public:
+        using commandhandler_t = std::conditional_t<std::is_void_v<COMMAND_TABLE>,
+                                                    CommandHandler<DERIVED,COMMAND_ID_ENUM,256>,
+                                                    StaticCommandHandler<DERIVED,COMMAND_ID_ENUM,COMMAND_TABLE,256>>;
+
         RicCoreSystem(typename CommandHandler<DERIVED,COMMAND_ID_ENUM,256>::commandMap_t commandmap,
                       const std::initializer_list<COMMAND_ID_ENUM> defaultEnabledCommands,
                       Stream &usbDebugPort):
@@ -44,9 +64,39 @@ class RicCoreSystem{
         networkmanager(254,NODETYPE::LEAF,true,200), //cant remember what happens if u intialize with address zero
         usb0(usbDebugPort,systemstatus,static_cast<uint8_t>(DEFAULT_INTERFACES::USBSERIAL),"usb0"),
         commandhandler(*(static_cast<DERIVED*>(this)),commandmap,static_cast<uint8_t>(DEFAULT_SERVICES::COMMAND),defaultEnabledCommands),
-        statemachine()
+        statemachine(),
+        scheduler()
         {};
 
+        /**
+         * @brief Construct the core system with a compile time command table
+         *
+         * @param defaultEnabledCommands
+         * @param usbDebugPort
+         */
+        RicCoreSystem(const std::initializer_list<COMMAND_ID_ENUM> defaultEnabledCommands,
+                      Stream &usbDebugPort):
+        systemstatus(),
+        loggerhandler(ILoggerHandler::getInstance()),
+        networkmanager(254,NODETYPE::LEAF,true,200),
+        usb0(usbDebugPort,systemstatus,static_cast<uint8_t>(DEFAULT_INTERFACES::USBSERIAL),"usb0"),
+        commandhandler(*(static_cast<DERIVED*>(this)),static_cast<uint8_t>(DEFAULT_SERVICES::COMMAND),defaultEnabledCommands),
+        statemachine(),
+        scheduler()
+        {
+            static_assert(!std::is_void_v<COMMAND_TABLE>,"Command map required when no compile time command table is given!");
+        };
+
+        /**
+         * @brief Stops the network thread before the members it uses (usb0, commandhandler...) are destroyed. The
+         * members of the derived system are destroyed before this runs, so a derived system which adds interfaces
+         * or services to the network manager must call networkmanager.stopPipeline() in its own destructor.
+         * 
+         */
+        ~RicCoreSystem(){
+            networkmanager.stopPipeline();
+        };
+
         /**
          * @brief Core System Setup, performs core system setup, default network manager intialization and finally 
          * calls the derived system setup functions. Intended to perform final setup for board communication busses,
@@ -77,12 +127,31 @@ class RicCoreSystem{
 
         /**
          * @brief core system update loop, calls the derived update loop aswell. Don't hide this function in the derived class!
+         * Periodic tasks registered with the scheduler are run last, and if idle yield is enabled on the scheduler the
+         * loop sleeps here until the next task is due. Each stage is timed when LIBRICCORE_PROFILING is defined.
          * 
          */
         void coreSystemUpdate(){
-            networkmanager.update();
-            static_cast<DERIVED*>(this)->systemUpdate();
-            statemachine.update();
+            {
+                RICCORE_PROFILE_SCOPE("network");
+                networkmanager.update();
+            }
+            {
+                RICCORE_PROFILE_SCOPE("commands");
+                commandhandler.update();
+            }
+            {
+                RICCORE_PROFILE_SCOPE("system");
+                static_cast<DERIVED*>(this)->systemUpdate();
+            }
+            {
+                RICCORE_PROFILE_SCOPE("statemachine");
+                statemachine.update();
+            }
+            {
+                RICCORE_PROFILE_SCOPE("scheduler");
+                scheduler.update();
+            }
         };
 
         /**
@@ -97,14 +166,22 @@ class RicCoreSystem{
 
         LoggerHandler& loggerhandler;
 
-        RnpNetworkManager networkmanager;
+        /**
+         * @brief Network manager, call networkmanager.startPipeline() at the end of systemSetup to run the network
+         * stack on its own core. Service callbacks are still called from coreSystemUpdate. Derived systems must call
+         * networkmanager.stopPipeline() in their destructor if they add interfaces, see ~RicCoreSystem.
+         * 
+         */
+        PipelinedNetworkManager<> networkmanager;
 
         StreamSerial<SYSTEM_FLAGS_T> usb0;
 
-        CommandHandler<DERIVED,COMMAND_ID_ENUM,256> commandhandler;
+        commandhandler_t commandhandler;
 
         StateMachine<SYSTEM_FLAGS_T> statemachine;
 
+        TaskScheduler<> scheduler;
+
 
     protected:
 
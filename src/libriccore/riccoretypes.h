@@ -14,8 +14,12 @@
 #include <memory>
 
 #include "commands/commandhandler.h"
+#include "commands/staticcommandhandler.h"
 #include "systemstatus/systemstatus.h"
 #include "fsm/state.h"
+#include "fsm/staticstate.h"
+#include "fsm/superstate.h"
+#include "fsm/orthogonalstate.h"
 
 /**
  * @brief Templated struct with type aliases inside to provide convient type access. Some of the template paramters might require
@@ -28,7 +32,12 @@
 template<typename SYSTEM_T,typename SYSTEM_FLAGS_T,typename COMMAND_ID_ENUM,size_t N_MAX_COMMANDS=256>
 struct RicCoreTypes{
     using CommandHandler_t = CommandHandler<SYSTEM_T,COMMAND_ID_ENUM,N_MAX_COMMANDS>;
+    template<typename COMMAND_TABLE>
+    using StaticCommandHandler_t = StaticCommandHandler<SYSTEM_T,COMMAND_ID_ENUM,COMMAND_TABLE,N_MAX_COMMANDS>;
     using SystemStatus_t = SystemStatus<SYSTEM_FLAGS_T>;
     using State_t = State<SYSTEM_FLAGS_T>;
     using State_ptr_t = std::unique_ptr<State_t>;
+    using StaticState_t = StaticState<SYSTEM_FLAGS_T>;
+    using SuperState_t = SuperState<SYSTEM_FLAGS_T>;
+    using OrthogonalState_t = OrthogonalState<SYSTEM_FLAGS_T>;
 };
@@ -0,0 +1,348 @@
+#pragma once
+/**
+ * @file taskscheduler.h
+ * @brief Cooperative rate monotonic scheduler for periodic tasks. Components register a callback with a period and a
+ * priority instead of each reimplementing a millis() delta check. Each update, every task whose release time has
+ * passed is run once, highest priority first, with ties broken by the shorter period (rate monotonic ordering, so
+ * leaving every priority at 0 gives a pure rate monotonic schedule). Releases are drift free, a task released late
+ * keeps its original phase, and releases missed entirely are skipped and counted rather than run back to back.
+ * Release jitter (start time - release time) and execution time are recorded per task in fixed memory, and an
+ * execution longer than the task period is counted as an overrun. When idle yield is enabled (it is off by default)
+ * the scheduler sleeps until shortly before the next release instead of letting the main loop busy wait. The sleep
+ * ends a wake margin early as a sleep can overrun by the scheduler latency of the os, which would otherwise show up
+ * directly as release jitter.
+ */
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+
+#include <libriccore/platform/millis.h>
+#include <libriccore/threading/riccorethread.h>
+#include <libriccore/util/durationstats.h>
+
+template <size_t N_MAX_TASKS = 16>
+class TaskScheduler
+{
+public:
+    using taskFunction_t = std::function<void()>;
+
+    TaskScheduler() : _tasks(),
+                      _order(),
+                      _numTasks(0),
+                      _maxIdleSleep(0),
+                      _idleWakeMargin(0),
+                      _idleTime(0){};
+
+    /**
+     * @brief Register a periodic task, the first release is immediate. Throws std::runtime_error if N_MAX_TASKS
+     * tasks are already registered.
+     *
+     * @param task callback run each period
+     * @param period release period [us]
+     * @param priority higher runs first, tasks of equal priority are ordered by period
+     * @return size_t task id
+     */
+    size_t addTask(taskFunction_t task, uint32_t period, uint8_t priority = 0)
+    {
+        if (_numTasks == N_MAX_TASKS)
+        {
+            throw std::runtime_error("Maximum number of scheduled tasks reached!");
+        }
+        if (period == 0)
+        {
+            throw std::runtime_error("Scheduled task period must be non zero!");
+        }
+
+        const size_t id = _numTasks++;
+        task_t &newTask = _tasks[id];
+        newTask.callback = std::move(task);
+        newTask.period = period;
+        newTask.priority = priority;
+        newTask.enabled = true;
+        newTask.nextRelease = micros64();
+        newTask.overruns = 0;
+        newTask.missed = 0;
+        newTask.execution.reset();
+        newTask.jitter.reset();
+
+        // insert into the dispatch order, kept sorted so update is a single pass
+        size_t position = id;
+        while (position > 0 && higherPriority(newTask, _tasks[_order[position - 1]]))
+        {
+            _order[position] = _order[position - 1];
+            --position;
+        }
+        _order[position] = id;
+
+        return id;
+    };
+
+    /**
+     * @brief Enable or disable a task. A re-enabled task is released immediately.
+     *
+     * @param id
+     * @param enabled
+     */
+    void setEnabled(size_t id, bool enabled)
+    {
+        task_t &task = getTask(id);
+        if (enabled && !task.enabled)
+        {
+            task.nextRelease = micros64();
+        }
+        task.enabled = enabled;
+    };
+
+    /**
+     * @brief Sleep between updates when no task is due. The sleep is capped so the rest of the main loop
+     * (e.g network polling) still runs at least every maxSleep ms. 0 disables idle yield (default). The sleep
+     * ends wakeMargin before the next release and the remainder is busy waited by the main loop, so increase the
+     * margin if release jitter rises with idle yield enabled.
+     *
+     * @param maxSleep maximum idle sleep [ms]
+     * @param wakeMargin time before the next release to wake up [us]
+     */
+    void setIdleYield(uint32_t maxSleep, uint32_t wakeMargin = 500)
+    {
+        _maxIdleSleep = maxSleep;
+        _idleWakeMargin = wakeMargin;
+    };
+
+    /**
+     * @brief Run every released task once in priority order, then yield if idle yield is enabled
+     *
+     */
+    void update()
+    {
+        for (size_t i = 0; i < _numTasks; i++)
+        {
+            task_t &task = _tasks[_order[i]];
+            if (!task.enabled)
+            {
+                continue;
+            }
+
+            const uint64_t start = micros64();
+            if (start < task.nextRelease)
+            {
+                continue;
+            }
+            const uint64_t lateness = start - task.nextRelease;
+
+            task.callback();
+            const uint32_t execution_time = static_cast<uint32_t>(micros64() - start);
+
+            task.jitter.record(static_cast<uint32_t>(lateness));
+            task.execution.record(execution_time);
+            if (execution_time > task.period)
+            {
+                ++task.overruns;
+            }
+
+            // keep the phase of the task, skipping any releases which have already been missed
+            const uint64_t elapsedPeriods = lateness / task.period;
+            task.missed += static_cast<uint32_t>(elapsedPeriods);
+            task.nextRelease += (elapsedPeriods + 1) * task.period;
+        }
+
+        if (_maxIdleSleep)
+        {
+            idleYield();
+        }
+    };
+
+    /**
+     * @brief Time until the next enabled task is released, 0 if a task is due now
+     *
+     * @return uint32_t [us]
+     */
+    uint32_t timeUntilNextRelease() const
+    {
+        const uint64_t now = micros64();
+        uint64_t nearest = UINT32_MAX;
+        for (size_t i = 0; i < _numTasks; i++)
+        {
+            const task_t &task = _tasks[i];
+            if (!task.enabled)
+            {
+                continue;
+            }
+            if (task.nextRelease <= now)
+            {
+                return 0;
+            }
+            if (task.nextRelease - now < nearest)
+            {
+                nearest = task.nextRelease - now;
+            }
+        }
+        return static_cast<uint32_t>(nearest);
+    };
+
+    /**
+     * @brief Release jitter statistics of a task [us]
+     *
+     * @param id
+     * @return const RicCoreUtil::DurationStats&
+     */
+    const RicCoreUtil::DurationStats &getJitterStats(size_t id) const { return getTask(id).jitter; };
+
+    /**
+     * @brief Execution time statistics of a task [us]
+     *
+     * @param id
+     * @return const RicCoreUtil::DurationStats&
+     */
+    const RicCoreUtil::DurationStats &getExecutionStats(size_t id) const { return getTask(id).execution; };
+
+    /**
+     * @brief Number of executions of a task which took longer than its period
+     *
+     * @param id
+     * @return uint32_t
+     */
+    uint32_t getOverruns(size_t id) const { return getTask(id).overruns; };
+
+    /**
+     * @brief Number of releases of a task which were skipped as the task was already more than a period late
+     *
+     * @param id
+     * @return uint32_t
+     */
+    uint32_t getMissedReleases(size_t id) const { return getTask(id).missed; };
+
+    /**
+     * @brief Total time spent sleeping in idle yield [us]
+     *
+     * @return uint64_t
+     */
+    uint64_t getIdleTime() const { return _idleTime; };
+
+    size_t getNumTasks() const { return _numTasks; };
+
+    /**
+     * @brief Serializes a summary of every task.
+     * Format: uint32 task count, {uint32 period, uint32 overruns, uint32 missed, DurationStats::summary_t jitter,
+     * DurationStats::summary_t execution}[count] in task id order
+     *
+     * @param buf buffer to append to
+     */
+    void serialize(std::vector<uint8_t> &buf) const
+    {
+        appendBytes(buf, static_cast<uint32_t>(_numTasks));
+        for (size_t i = 0; i < _numTasks; i++)
+        {
+            const task_t &task = _tasks[i];
+            appendBytes(buf, task.period);
+            appendBytes(buf, task.overruns);
+            appendBytes(buf, task.missed);
+            appendBytes(buf, task.jitter.summary());
+            appendBytes(buf, task.execution.summary());
+        }
+    };
+
+    /**
+     * @brief Reset all task statistics and the idle time
+     *
+     */
+    void resetStats()
+    {
+        for (size_t i = 0; i < _numTasks; i++)
+        {
+            _tasks[i].jitter.reset();
+            _tasks[i].execution.reset();
+            _tasks[i].overruns = 0;
+            _tasks[i].missed = 0;
+        }
+        _idleTime = 0;
+    };
+
+private:
+    struct task_t
+    {
+        taskFunction_t callback;
+        uint32_t period;
+        uint8_t priority;
+        bool enabled;
+        uint64_t nextRelease; // monotonic [us]
+        uint32_t overruns;
+        uint32_t missed;
+        RicCoreUtil::DurationStats jitter;
+        RicCoreUtil::DurationStats execution;
+    };
+
+    std::array<task_t, N_MAX_TASKS> _tasks;
+
+    /**
+     * @brief Task ids sorted by dispatch order
+     *
+     */
+    std::array<size_t, N_MAX_TASKS> _order;
+
+    size_t _numTasks;
+
+    uint32_t _maxIdleSleep;
+    uint32_t _idleWakeMargin;
+
+    uint64_t _idleTime;
+
+    static bool higherPriority(const task_t &a, const task_t &b)
+    {
+        if (a.priority != b.priority)
+        {
+            return a.priority > b.priority;
+        }
+        return a.period < b.period;
+    };
+
+    const task_t &getTask(size_t id) const
+    {
+        if (id >= _numTasks)
+        {
+            throw std::out_of_range("Scheduled task id out of range!");
+        }
+        return _tasks[id];
+    };
+
+    task_t &getTask(size_t id)
+    {
+        return const_cast<task_t &>(static_cast<const TaskScheduler *>(this)->getTask(id));
+    };
+
+    /**
+     * @brief Sleep until the wake margin before the next release in whole ms, capped at the max idle sleep. Sub ms
+     * waits are left to the main loop as the delay granularity on the esp32 is a tick.
+     *
+     */
+    void idleYield()
+    {
+        const uint32_t untilRelease = timeUntilNextRelease();
+        if (untilRelease <= _idleWakeMargin)
+        {
+            return;
+        }
+        uint32_t sleep = (untilRelease - _idleWakeMargin) / 1000;
+        if (sleep > _maxIdleSleep)
+        {
+            sleep = _maxIdleSleep;
+        }
+        if (sleep == 0)
+        {
+            return;
+        }
+        const uint64_t start = micros64();
+        RicCoreThread::delay(sleep);
+        _idleTime += micros64() - start;
+    };
+
+    template <typename T>
+    static void appendBytes(std::vector<uint8_t> &buf, const T &value)
+    {
+        const size_t offset = buf.size();
+        buf.resize(offset + sizeof(T));
+        std::memcpy(buf.data() + offset, &value, sizeof(T));
+    };
+};
@@ -0,0 +1,133 @@
+/**
+ * @file atomicbitwiseflagmanager.h
+ * @brief Thread safe variant of the BitwiseFlagManager. The flags are held in a std::atomic so flags can be raised and
+ * removed concurrently from multiple threads without losing updates, and checked without locking. newFlag and
+ * deleteFlag report whether the call actually changed a flag so callers can act on edges only.
+ * Note the underlying type should be no wider than the platform word (e.g 32 bit on the esp32) for the atomic
+ * operations to be lock free.
+ */
+
+#pragma once
+#include <type_traits>
+#include <atomic>
+#include <cstdint>
+
+template<typename T,typename T_underlying = typename std::underlying_type<T>::type>
+class AtomicBitwiseFlagManager
+{
+   static_assert(std::is_integral_v<T_underlying>,"Underlying Type must be int castable");
+
+public:
+    /**
+     * @brief Type of a flag mask and of the status
+     *
+     */
+    using status_t = T_underlying;
+
+    AtomicBitwiseFlagManager() : _statusString(static_cast<T_underlying>(0)){};
+
+    AtomicBitwiseFlagManager(T initalStatus) : _statusString(static_cast<T_underlying>(initalStatus)){};
+
+    AtomicBitwiseFlagManager(T_underlying initalStatus) : _statusString(initalStatus){};
+
+    T_underlying getStatus() const { return _statusString.load(std::memory_order_acquire); };
+
+    /**
+     * @brief Status truncated to 32 bits for logging
+     *
+     * @param flag
+     * @return uint32_t
+     */
+    uint32_t getStatusWord(T flag) const { return static_cast<uint32_t>(getStatus()); };
+
+    /**
+     * @brief Generate a mask of the given flags
+     *
+     * @param args
+     * @return constexpr status_t
+     */
+    template <typename... Args>
+    static constexpr status_t mask(Args... args)
+    {
+        return (static_cast<T_underlying>(0) | ... | static_cast<T_underlying>(args));
+    };
+
+    /**
+     * @brief Check if flag is part of mask
+     *
+     * @param flagMask
+     * @param flag
+     * @return true
+     * @return false
+     */
+    static constexpr bool masked(const status_t &flagMask, T flag)
+    {
+        return (flagMask & static_cast<T_underlying>(flag));
+    };
+
+    /**
+     * @brief Raise flag
+     *
+     * @param flag
+     * @return true flag was not previously set
+     * @return false flag was already set
+     */
+    bool newFlag(T flag)
+    {
+        const T_underlying mask = static_cast<T_underlying>(flag);
+        const T_underlying previous = _statusString.fetch_or(mask, std::memory_order_acq_rel);
+        return (~previous & mask);
+    };
+
+    /**
+     * @brief Remove flag
+     *
+     * @param flag
+     * @return true flag was previously set
+     * @return false flag was already cleared
+     */
+    bool deleteFlag(T flag)
+    {
+        const T_underlying mask = static_cast<T_underlying>(flag);
+        const T_underlying previous = _statusString.fetch_and(~mask, std::memory_order_acq_rel);
+        return (previous & mask);
+    };
+
+    bool flagSet(T flag) const
+    {
+        return flagSetOr(flag);
+    };
+
+    /**
+     * @brief Checks if multiple flags have been triggered e.g flag1 or flag2 or ...
+     *
+     * @param args
+     * @return true
+     * @return false
+     */
+    template <typename... Args>
+    bool flagSetOr(Args... args) const
+    {
+        const T_underlying flags = mask(args...);
+        return (getStatus() & flags);
+    };
+
+    /**
+     * @brief Checks if all multiple flags have been triggered e.g flag1 and flag2 and ...
+     *
+     * @param args
+     * @return true
+     * @return false
+     */
+    template <typename... Args>
+    bool flagSetAnd(Args... args) const
+    {
+        const T_underlying flags = mask(args...);
+        return ((getStatus() & flags) == flags);
+    };
+
+    virtual ~AtomicBitwiseFlagManager(){};
+
+protected:
+    std::atomic<T_underlying> _statusString;
+};
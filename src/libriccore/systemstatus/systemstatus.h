@@ -10,22 +10,85 @@
  */
 
 #pragma once
-#include "bitwiseflagmanager.h"
+#include "atomicbitwiseflagmanager.h"
+#include "widebitwiseflagmanager.h"
 
 #include <string>
+#include <cstring>
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <stdexcept>
 
 #include <libriccore/riccorelogging.h>
+#include <libriccore/platform/millis.h>
+#include <libriccore/threading/scopedlock.h>
 
 
 
-
+/**
+ * @brief System status flags. Flags are stored atomically so the status can be updated from any thread
+ * (main loop, storage flush thread, interfaces). Changes are only logged on an edge, raising a flag which
+ * is already raised or removing a flag which is already removed is silent.
+ * Every edge is recorded in a fixed size timestamped history which can be serialized into a BinaryPacket and
+ * sent over rnp, and subscribers can register a callback to be notified of edges instead of polling.
+ * Flag enums with more flags than fit in an integral type can be used by specializing WideFlags for the enum,
+ * the flags are then bit indices stored by the WideBitwiseFlagManager.
+ *
+ */
 template<typename SYSTEM_FLAGS_T,RicCoreLoggingConfig::LOGGERS LOGGING_TARGET = RicCoreLoggingConfig::LOGGERS::SYS>
-class SystemStatus : public BitwiseFlagManager<SYSTEM_FLAGS_T>
+class SystemStatus : public std::conditional_t<WideFlags<SYSTEM_FLAGS_T>::value == 0,
+                                                AtomicBitwiseFlagManager<SYSTEM_FLAGS_T>,
+                                                WideBitwiseFlagManager<SYSTEM_FLAGS_T, WideFlags<SYSTEM_FLAGS_T>::value>>
 {
     // check passed system_flags_t for default flags present
+
+    using T_underlying = std::underlying_type_t<SYSTEM_FLAGS_T>;
+
+    using flagmanager_t = std::conditional_t<WideFlags<SYSTEM_FLAGS_T>::value == 0,
+                                             AtomicBitwiseFlagManager<SYSTEM_FLAGS_T>,
+                                             WideBitwiseFlagManager<SYSTEM_FLAGS_T, WideFlags<SYSTEM_FLAGS_T>::value>>;
+
+    using status_t = typename flagmanager_t::status_t;
     
 public:
-    SystemStatus() : BitwiseFlagManager<SYSTEM_FLAGS_T>::BitwiseFlagManager(0)
+    /**
+     * @brief Number of flag changes kept in the history
+     *
+     */
+    static constexpr size_t HISTORY_SIZE = 32;
+
+    /**
+     * @brief Maximum number of subscriptions, unsubscribed slots are not reused
+     *
+     */
+    static constexpr size_t MAX_SUBSCRIBERS = 8;
+
+    /**
+     * @brief Flag change history entry
+     *
+     */
+    struct flag_event_t
+    {
+        uint64_t timestamp; // monotonic [us]
+        T_underlying flag;
+        status_t status; // status after the change
+        bool raised; // true if raised, false if removed
+    };
+
+    /**
+     * @brief Callback called on flag edges with the flag and true if it was raised, false if it was removed
+     *
+     */
+    using subscriberCallback_t = std::function<void(SYSTEM_FLAGS_T, bool)>;
+
+    SystemStatus() : flagmanager_t(),
+                     _subscribers(),
+                     _numSubscribers(0),
+                     _history(),
+                     _historyCount(0)
                      {};
 
 
@@ -37,26 +100,178 @@ public:
      */
     void newFlag(SYSTEM_FLAGS_T flag, std::string_view info)
     {
-        BitwiseFlagManager<SYSTEM_FLAGS_T>::newFlag(flag);
-        RicCoreLogging::log<LOGGING_TARGET>(this->getStatus(), static_cast<uint32_t>(flag), info);
+        if (flagmanager_t::newFlag(flag))
+        {
+            RicCoreLogging::log<LOGGING_TARGET>(this->getStatusWord(flag), static_cast<uint32_t>(flag), info);
+            onEdge(flag, true);
+        }
     };
 
-    void newFlag(SYSTEM_FLAGS_T flag) override
+    void newFlag(SYSTEM_FLAGS_T flag)
     {
-        BitwiseFlagManager<SYSTEM_FLAGS_T>::newFlag(flag);
-        RicCoreLogging::log<LOGGING_TARGET>(this->getStatus(), static_cast<uint32_t>(flag), "flag raised");
+        newFlag(flag, "flag raised");
     };
 
-    void deleteFlag(SYSTEM_FLAGS_T flag) override
+    void deleteFlag(SYSTEM_FLAGS_T flag)
     {
-        BitwiseFlagManager<SYSTEM_FLAGS_T>::deleteFlag(flag);
-        RicCoreLogging::log<LOGGING_TARGET>(this->getStatus(), static_cast<uint32_t>(flag), "flag removed");
+        deleteFlag(flag, "flag removed");
     };
 
     void deleteFlag(SYSTEM_FLAGS_T flag, std::string_view info)
     {
-        BitwiseFlagManager<SYSTEM_FLAGS_T>::deleteFlag(flag);
-        RicCoreLogging::log<LOGGING_TARGET>(this->getStatus(), static_cast<uint32_t>(flag), info);
+        if (flagmanager_t::deleteFlag(flag))
+        {
+            RicCoreLogging::log<LOGGING_TARGET>(this->getStatusWord(flag), static_cast<uint32_t>(flag), info);
+            onEdge(flag, false);
+        }
+    };
+
+    /**
+     * @brief Subscribe to edges of any of the given flags. The callback is called from the thread which changed
+     * the flag so should be short, e.g signal a waiting thread. Can be called from any thread while flags are
+     * changing, the subscriber table is fixed size and a subscription is only published to onEdge once it is
+     * complete. Throws std::runtime_error if MAX_SUBSCRIBERS subscriptions have been made.
+     *
+     * @tparam Args flags
+     * @param callback
+     * @param flags flags to be notified of
+     * @return size_t subscription id used to unsubscribe
+     */
+    template <typename... Args>
+    size_t subscribe(subscriberCallback_t callback, Args... flags)
+    {
+        RicCoreThread::ScopedLock sl(_subscriberLock);
+        const size_t id = _numSubscribers.load(std::memory_order_relaxed);
+        if (id == MAX_SUBSCRIBERS)
+        {
+            throw std::runtime_error("Maximum number of system status subscribers exceeded!");
+        }
+        subscriber_t &subscriber = _subscribers[id];
+        subscriber.mask = flagmanager_t::mask(flags...);
+        subscriber.callback = std::move(callback);
+        subscriber.active.store(true, std::memory_order_relaxed);
+        _numSubscribers.store(id + 1, std::memory_order_release);
+        return id;
+    };
+
+    /**
+     * @brief Remove a subscription. The callback is kept alive rather than destroyed, so an edge on another thread
+     * may still be running it when unsubscribe returns, but it won't be called for any later edge.
+     *
+     * @param id
+     */
+    void unsubscribe(size_t id)
+    {
+        if (id < _numSubscribers.load(std::memory_order_acquire))
+        {
+            _subscribers[id].active.store(false, std::memory_order_release);
+        }
+    };
+
+    /**
+     * @brief Copies the flag change history into dest ordered oldest to newest
+     *
+     * @param dest
+     * @return size_t number of entries copied
+     */
+    size_t getHistory(std::array<flag_event_t, HISTORY_SIZE> &dest) const
+    {
+        RicCoreThread::ScopedLock sl(_historyLock);
+        const size_t count = std::min(_historyCount, HISTORY_SIZE);
+        const size_t begin = _historyCount - count;
+        for (size_t i = 0; i < count; i++)
+        {
+            dest[i] = _history[(begin + i) % HISTORY_SIZE];
+        }
+        return count;
+    };
+
+    /**
+     * @brief Total number of flag changes, including those which have been overwritten in the history
+     *
+     * @return size_t
+     */
+    size_t getChangeCount() const
+    {
+        RicCoreThread::ScopedLock sl(_historyLock);
+        return _historyCount;
+    };
+
+    /**
+     * @brief Serializes the flag change history, can be sent with BinaryPacket::fromSerializable.
+     * Format: uint32 entry count, {uint64 timestamp, T_underlying flag, status_t status, uint8 raised}[count]
+     * where T_underlying is the underlying type of the system flags enum and status_t is T_underlying, or for wide
+     * flags N_WORDS uint32 words.
+     *
+     * @param buf buffer to append to
+     */
+    void serialize(std::vector<uint8_t> &buf) const
+    {
+        std::array<flag_event_t, HISTORY_SIZE> history;
+        const uint32_t count = getHistory(history);
+
+        appendBytes(buf, count);
+        for (size_t i = 0; i < count; i++)
+        {
+            appendBytes(buf, history[i].timestamp);
+            appendBytes(buf, history[i].flag);
+            appendBytes(buf, history[i].status);
+            appendBytes(buf, static_cast<uint8_t>(history[i].raised));
+        }
+    };
+
+private:
+    struct subscriber_t
+    {
+        status_t mask;
+        subscriberCallback_t callback;
+        std::atomic<bool> active{false};
+    };
+
+    /**
+     * @brief Subscriptions, slots below _numSubscribers are immutable apart from active so onEdge reads them
+     * without locking. _subscriberLock only serializes subscribe calls.
+     *
+     */
+    std::array<subscriber_t, MAX_SUBSCRIBERS> _subscribers;
+    std::atomic<size_t> _numSubscribers;
+    RicCoreThread::Lock_t _subscriberLock;
+
+    mutable RicCoreThread::Lock_t _historyLock;
+    std::array<flag_event_t, HISTORY_SIZE> _history;
+    size_t _historyCount;
+
+    /**
+     * @brief Record the edge in the history and notify subscribers
+     *
+     * @param flag
+     * @param raised
+     */
+    void onEdge(SYSTEM_FLAGS_T flag, bool raised)
+    {
+        {
+            RicCoreThread::ScopedLock sl(_historyLock);
+            _history[_historyCount % HISTORY_SIZE] = flag_event_t{micros64(), static_cast<T_underlying>(flag), this->getStatus(), raised};
+            ++_historyCount;
+        }
+
+        const size_t numSubscribers = _numSubscribers.load(std::memory_order_acquire);
+        for (size_t i = 0; i < numSubscribers; i++)
+        {
+            const subscriber_t &subscriber = _subscribers[i];
+            if (subscriber.active.load(std::memory_order_acquire) && flagmanager_t::masked(subscriber.mask, flag))
+            {
+                subscriber.callback(flag, raised);
+            }
+        }
+    };
+
+    template <typename T>
+    static void appendBytes(std::vector<uint8_t> &buf, const T &value)
+    {
+        const size_t offset = buf.size();
+        buf.resize(offset + sizeof(T));
+        std::memcpy(buf.data() + offset, &value, sizeof(T));
     };
 
-};
+};
\ No newline at end of file
@@ -0,0 +1,283 @@
+/**
+ * @file widebitwiseflagmanager.h
+ * @brief Flag manager for flag sets wider than the largest integral type. Unlike the BitwiseFlagManager where each
+ * enum value is a bit mask, the enum values of a wide flag set are bit indices (like command ids), so the flag set
+ * can grow past 64 flags. Flags are stored in an array of atomic 32 bit words which keeps updates lock free on the
+ * esp32, and flag checks compile down to word-wise mask operations. The interface matches AtomicBitwiseFlagManager.
+ *
+ * To use a wide flag set for a system, specialize WideFlags with the number of flags before SystemStatus is used:
+ *
+ *   template<> struct WideFlags<SYSTEM_FLAGS> : std::integral_constant<size_t, 128> {};
+ */
+
+#pragma once
+#include <type_traits>
+#include <atomic>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <stdexcept>
+#include <initializer_list>
+
+#include <libriccore/util/bitsethelpers.h>
+
+/**
+ * @brief Number of flags of a wide flag set enum, 0 for a normal bit mask flag enum. Specialize for wide flag
+ * enums to make SystemStatus use the WideBitwiseFlagManager.
+ *
+ * @tparam T flag enum
+ */
+template <typename T>
+struct WideFlags : std::integral_constant<size_t, 0>
+{
+};
+
+template <typename T, size_t N_FLAGS>
+class WideBitwiseFlagManager
+{
+    static_assert(std::is_enum_v<T>, "Wide flags must be an enum of bit indices");
+    static_assert(N_FLAGS > 0, "Wide flag set must have at least one flag");
+
+    using T_underlying = std::underlying_type_t<T>;
+
+public:
+    using word_t = uint32_t;
+
+    static constexpr size_t WORD_BITS = sizeof(word_t) * 8;
+
+    static constexpr size_t N_WORDS = (N_FLAGS + WORD_BITS - 1) / WORD_BITS;
+
+    /**
+     * @brief Type of a flag mask and of the status, word i holds flags [32i, 32i + 31]
+     *
+     */
+    using status_t = std::array<word_t, N_WORDS>;
+
+    WideBitwiseFlagManager()
+    {
+        for (std::atomic<word_t> &word : _statusWords)
+        {
+            word.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * @brief Get a copy of the status. Each word is read atomically, but the words are not read as a single
+     * snapshot.
+     *
+     * @return status_t
+     */
+    status_t getStatus() const
+    {
+        status_t status;
+        for (size_t i = 0; i < N_WORDS; i++)
+        {
+            status[i] = _statusWords[i].load(std::memory_order_acquire);
+        }
+        return status;
+    };
+
+    /**
+     * @brief Get the status as a bitset
+     *
+     * @return std::bitset<N_FLAGS>
+     */
+    std::bitset<N_FLAGS> getStatusBitset() const
+    {
+        std::bitset<N_FLAGS> status;
+        for (size_t i = N_WORDS; i-- > 0;)
+        {
+            status <<= WORD_BITS;
+            status |= std::bitset<N_FLAGS>(_statusWords[i].load(std::memory_order_acquire));
+        }
+        return status;
+    };
+
+    /**
+     * @brief Status word containing the given flag, used for logging
+     *
+     * @param flag
+     * @return uint32_t
+     */
+    uint32_t getStatusWord(T flag) const
+    {
+        return _statusWords[wordIndex(flag)].load(std::memory_order_acquire);
+    };
+
+    /**
+     * @brief Generate a mask of the given flags
+     *
+     * @param args
+     * @return constexpr status_t
+     */
+    template <typename... Args>
+    static constexpr status_t mask(Args... args)
+    {
+        status_t flagMask{};
+        (checkFlag(args), ...);
+        ((flagMask[wordIndex(args)] |= bitMask(args)), ...);
+        return flagMask;
+    };
+
+    /**
+     * @brief Generate a mask from a bitset, e.g one generated with generateFlags
+     *
+     * @param flags
+     * @return status_t
+     */
+    static status_t mask(const std::bitset<N_FLAGS> &flags)
+    {
+        status_t flagMask{};
+        for (size_t i = 0; i < N_FLAGS; i++)
+        {
+            if (flags[i])
+            {
+                flagMask[i / WORD_BITS] |= static_cast<word_t>(1) << (i % WORD_BITS);
+            }
+        }
+        return flagMask;
+    };
+
+    /**
+     * @brief Generate a bitset of the given flags
+     *
+     * @param flags
+     * @return std::bitset<N_FLAGS>
+     */
+    static std::bitset<N_FLAGS> generateFlags(const std::initializer_list<T> flags)
+    {
+        return RicCoreUtil::BitsetHelpers::generateBitset<N_FLAGS>(flags);
+    };
+
+    /**
+     * @brief Check if flag is part of mask
+     *
+     * @param flagMask
+     * @param flag
+     * @return true
+     * @return false
+     */
+    static constexpr bool masked(const status_t &flagMask, T flag)
+    {
+        return (flagMask[wordIndex(flag)] & bitMask(flag));
+    };
+
+    /**
+     * @brief Raise flag. Throws std::out_of_range if the flag index exceeds N_FLAGS.
+     *
+     * @param flag
+     * @return true flag was not previously set
+     * @return false flag was already set
+     */
+    bool newFlag(T flag)
+    {
+        checkFlag(flag);
+        const word_t bit = bitMask(flag);
+        const word_t previous = _statusWords[wordIndex(flag)].fetch_or(bit, std::memory_order_acq_rel);
+        return !(previous & bit);
+    };
+
+    /**
+     * @brief Remove flag. Throws std::out_of_range if the flag index exceeds N_FLAGS.
+     *
+     * @param flag
+     * @return true flag was previously set
+     * @return false flag was already cleared
+     */
+    bool deleteFlag(T flag)
+    {
+        checkFlag(flag);
+        const word_t bit = bitMask(flag);
+        const word_t previous = _statusWords[wordIndex(flag)].fetch_and(~bit, std::memory_order_acq_rel);
+        return (previous & bit);
+    };
+
+    bool flagSet(T flag) const
+    {
+        checkFlag(flag);
+        return (_statusWords[wordIndex(flag)].load(std::memory_order_acquire) & bitMask(flag));
+    };
+
+    /**
+     * @brief Checks if multiple flags have been triggered e.g flag1 or flag2 or ...
+     *
+     * @param args
+     * @return true
+     * @return false
+     */
+    template <typename... Args>
+    bool flagSetOr(Args... args) const
+    {
+        return flagSetOr(mask(args...));
+    };
+
+    bool flagSetOr(const status_t &flagMask) const
+    {
+        for (size_t i = 0; i < N_WORDS; i++)
+        {
+            if (flagMask[i] && (_statusWords[i].load(std::memory_order_acquire) & flagMask[i]))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    bool flagSetOr(const std::bitset<N_FLAGS> &flags) const
+    {
+        return flagSetOr(mask(flags));
+    };
+
+    /**
+     * @brief Checks if all multiple flags have been triggered e.g flag1 and flag2 and ...
+     *
+     * @param args
+     * @return true
+     * @return false
+     */
+    template <typename... Args>
+    bool flagSetAnd(Args... args) const
+    {
+        return flagSetAnd(mask(args...));
+    };
+
+    bool flagSetAnd(const status_t &flagMask) const
+    {
+        for (size_t i = 0; i < N_WORDS; i++)
+        {
+            if (flagMask[i] && ((_statusWords[i].load(std::memory_order_acquire) & flagMask[i]) != flagMask[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    bool flagSetAnd(const std::bitset<N_FLAGS> &flags) const
+    {
+        return flagSetAnd(mask(flags));
+    };
+
+    virtual ~WideBitwiseFlagManager(){};
+
+protected:
+    std::array<std::atomic<word_t>, N_WORDS> _statusWords;
+
+    static constexpr size_t wordIndex(T flag)
+    {
+        return static_cast<size_t>(static_cast<T_underlying>(flag)) / WORD_BITS;
+    };
+
+    static constexpr word_t bitMask(T flag)
+    {
+        return static_cast<word_t>(1) << (static_cast<size_t>(static_cast<T_underlying>(flag)) % WORD_BITS);
+    };
+
+    static constexpr void checkFlag(T flag)
+    {
+        if (static_cast<size_t>(static_cast<T_underlying>(flag)) >= N_FLAGS)
+        {
+            throw std::out_of_range("Flag exceeds wide flag set size!");
+        }
+    };
+};
@@ -2,6 +2,8 @@
 #include <string>
 #include <functional>
 #include <atomic>
+#include <array>
+#include <memory>
 
 #include <libriccore/platform/riccorethread_types.h>
 
@@ -35,10 +37,11 @@ namespace RicCoreThread
          *
          * @param f_ptr pointer to function to run inside thread.
          * @param args void pointer to function arguments
-         * @param stack_size stack size [ignored for unix]
-         * @param priority priority of running task [ignored for unix]
-         * @param coreID id for core to run on, 2 for no core affinity [ignored for unix]
-         * @param name name of thread
+         * @param stack_size stack size, 0 for the platform default [bytes]
+         * @param priority priority of running task, on unix priorities above 0 lower the nice value, and only
+         * priorities of at least LIBRICCORE_UNIX_RT_PRIORITY (off by default) use SCHED_FIFO
+         * @param coreID id for core to run on, 2 for no core affinity. On unix ignored if the cpu isn't available.
+         * @param name name of thread, truncated to 15 characters on unix
          */
         Thread(
             std::function<void(void *)> f_ptr,
@@ -51,15 +54,137 @@ namespace RicCoreThread
         ~Thread();
 
         /**
-         * @brief Join blocks the caller thread until this thread instance terminates
+         * @brief Join blocks the caller thread until this thread instance terminates. The caller blocks on a
+         * completion event set when the thread function returns, rather than polling.
          *
          */
         void join();
 
+        /**
+         * @brief Join with a timeout
+         *
+         * @param timeout [ms]
+         * @return true the thread has terminated
+         * @return false timed out, the thread is still running
+         */
+        bool join(uint32_t timeout);
+
     private:
         ThreadHandle_t handle;
         bool success; // not sure why this is here? -> need to clarify what exceptions thread construion will throw
         std::atomic<bool> deleted; //required to check if a freertos task has already been deleted.
+
+        /**
+         * @brief Set when the thread function returns. Shared with the running thread as on the esp32 the task
+         * outlives the set call, so must keep the event alive if the Thread is destroyed as soon as join returns.
+         *
+         */
+        std::shared_ptr<Event_t> completion;
+    };
+
+    /**
+     * @brief Base of StaticThread, runs a task on a stack and task control block owned by the caller so creating the
+     * thread does no heap allocation and can't fail from heap fragmentation. On the esp32 this uses
+     * xTaskCreateStaticPinnedToCore. On unix the stack buffer is used if it is at least PTHREAD_STACK_MIN, otherwise
+     * the thread gets a default stack of the same size.
+     * The task is a plain function pointer rather than a std::function so no captures need storing on the heap.
+     * When the task function returns the task is suspended rather than deleting itself, and is deleted by the
+     * destructor. This means the stack and control block are never reused while freertos still references them.
+     * On the esp32 join() can return just before the task has suspended, so the destructor blocks until it has. The
+     * task raises itself to the maximum priority before signalling completion, so a joiner of higher priority than
+     * the thread doesn't pre-empt it first; a joiner on the other core may still wait a tick in the destructor.
+     */
+    class StaticThreadBase
+    {
+    public:
+        using taskFunction_t = void (*)(void *);
+
+        ~StaticThreadBase();
+
+        StaticThreadBase(const StaticThreadBase &) = delete;
+        StaticThreadBase &operator=(const StaticThreadBase &) = delete;
+
+        /**
+         * @brief Join blocks the caller thread until the task function returns
+         *
+         */
+        void join();
+
+        /**
+         * @brief Join with a timeout
+         *
+         * @param timeout [ms]
+         * @return true the task function has returned
+         * @return false timed out
+         */
+        bool join(uint32_t timeout);
+
+    protected:
+        StaticThreadBase(taskFunction_t f_ptr,
+                         void *args,
+                         Stack_t *stack,
+                         const size_t stack_size,
+                         TaskBuffer_t *taskBuffer,
+                         const int priority,
+                         const Thread::CORE_ID coreID,
+                         std::string_view name);
+
+    private:
+        taskFunction_t taskCode;
+        void *taskArgs;
+        ThreadHandle_t handle;
+        Event_t completion; // set when the task function has returned
+
+        static void taskEntry(void *arg);
+    };
+
+    /**
+     * @brief Storage of a StaticThread, a separate base so it is constructed before the task is started
+     *
+     * @tparam STACK_SIZE [bytes]
+     */
+    template <size_t STACK_SIZE>
+    struct StaticThreadStorage
+    {
+        static_assert(STACK_SIZE % sizeof(Stack_t) == 0, "Static thread stack size must be a multiple of the stack type!");
+
+        alignas(16) std::array<Stack_t, STACK_SIZE / sizeof(Stack_t)> stack;
+        TaskBuffer_t taskBuffer;
+    };
+
+    /**
+     * @brief Thread with a statically sized stack and task control block owned by this object. Declare long lived
+     * threads as members or globals of StaticThread to avoid any heap allocation, e.g
+     * StaticThread<4096> thread(loop, this, 2, Thread::CORE_ID::CORE1, "loop");
+     *
+     * @tparam STACK_SIZE [bytes]
+     */
+    template <size_t STACK_SIZE>
+    class StaticThread : private StaticThreadStorage<STACK_SIZE>, public StaticThreadBase
+    {
+    public:
+        /**
+         * @brief Construct and launch a new Static Thread
+         *
+         * @param f_ptr function to run inside thread
+         * @param args void pointer to function arguments
+         * @param priority priority of running task
+         * @param coreID id for core to run on
+         * @param name name of thread
+         */
+        StaticThread(taskFunction_t f_ptr,
+                     void *args,
+                     const int priority = 0,
+                     const Thread::CORE_ID coreID = Thread::CORE_ID::ANYCORE,
+                     std::string_view name = "") : StaticThreadStorage<STACK_SIZE>(),
+                                                   StaticThreadBase(f_ptr,
+                                                                    args,
+                                                                    this->stack.data(),
+                                                                    STACK_SIZE,
+                                                                    &this->taskBuffer,
+                                                                    priority,
+                                                                    coreID,
+                                                                    name){};
     };
 
     /**
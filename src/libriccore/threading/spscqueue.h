@@ -0,0 +1,83 @@
+#pragma once
+/**
+ * @file spscqueue.h
+ * @brief Lock free single producer single consumer ring buffer. Exactly one thread may push and exactly one
+ * (possibly different) thread may pop, e.g to hand packets between the network and control loops running on
+ * different cores. Storage is fixed at compile time so neither end allocates or blocks.
+ */
+#include <cstddef>
+#include <array>
+#include <atomic>
+#include <utility>
+
+namespace RicCoreThread
+{
+    template <typename T, size_t N>
+    class SpscQueue
+    {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two!");
+
+    public:
+        SpscQueue() : _head(0),
+                      _tail(0){};
+
+        /**
+         * @brief Push an item, producer only.
+         *
+         * @param item moved from only if pushed
+         * @return true item pushed
+         * @return false queue full
+         */
+        bool push(T &&item)
+        {
+            const size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _head.load(std::memory_order_acquire) == N)
+            {
+                return false;
+            }
+            _buffer[tail & (N - 1)] = std::move(item);
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        };
+
+        /**
+         * @brief Pop the oldest item, consumer only.
+         *
+         * @param item destination
+         * @return true item popped
+         * @return false queue empty
+         */
+        bool pop(T &item)
+        {
+            const size_t head = _head.load(std::memory_order_relaxed);
+            if (head == _tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            item = std::move(_buffer[head & (N - 1)]);
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        };
+
+        /**
+         * @brief Number of items queued, only a snapshot when called concurrently with push or pop
+         *
+         * @return size_t
+         */
+        size_t size() const
+        {
+            return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+        };
+
+        bool empty() const { return size() == 0; };
+
+        static constexpr size_t capacity() { return N; };
+
+    private:
+        std::array<T, N> _buffer;
+
+        // head and tail are on separate cache lines so the producer and consumer don't contend
+        alignas(64) std::atomic<size_t> _head;
+        alignas(64) std::atomic<size_t> _tail;
+    };
+};
@@ -0,0 +1,424 @@
+#pragma once
+/**
+ * @file threadpool.h
+ * @brief Fixed size work stealing thread pool for cpu bound work (log decoding, replay, checksum verification etc).
+ * Each worker owns a deque of tasks, a worker pushes and pops tasks it submits at the back of its own deque (so
+ * recursively split work stays cache local), and an idle worker steals from the front of another worker's deque.
+ * Tasks submitted from outside the pool are distributed round robin. Workers are RicCoreThread::Thread's so they are
+ * std::threads on unix and freertos tasks on the esp32, where they can be pinned alternately to each core.
+ * submit() returns a TaskFuture, a shared completion state whose event is only signalled if a thread is blocked
+ * waiting, so completing a task nobody waits on (or checking ready()) takes no locks. Waiting on a future from
+ * inside a worker runs other queued tasks rather than blocking, so tasks can wait on tasks they submit without
+ * deadlocking the pool.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <string>
+#include <stdexcept>
+
+#include <libriccore/platform/riccorethread_types.h>
+#include "riccorethread.h"
+#include "scopedlock.h"
+
+namespace RicCoreThread
+{
+    class ThreadPool;
+
+    /**
+     * @brief Completion state shared between a submitted task and its future. The completing thread stores _ready then
+     * checks _waiting, and a waiter stores _waiting then checks _ready, both sequentially consistent, so either the
+     * waiter sees the task ready or the completing thread sees the waiter and sets the event.
+     *
+     * @tparam T task result type
+     */
+    template <typename T>
+    class TaskState
+    {
+    public:
+        TaskState() : _ready(false),
+                      _waiting(false){};
+
+        template <typename F>
+        void run(F &f)
+        {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    f();
+                }
+                else
+                {
+                    _value.emplace(f());
+                }
+            }
+            catch (...)
+            {
+                _exception = std::current_exception();
+            }
+            _ready.store(true);
+            if (_waiting.load())
+            {
+                _complete.set();
+            }
+        };
+
+        bool ready() const { return _ready.load(std::memory_order_acquire); };
+
+        /**
+         * @brief Block until the task completes
+         *
+         */
+        void wait()
+        {
+            if (ready())
+            {
+                return;
+            }
+            _waiting.store(true);
+            if (_ready.load())
+            {
+                return;
+            }
+            _complete.wait();
+        };
+
+        std::optional<std::conditional_t<std::is_void_v<T>, bool, T>> _value;
+        std::exception_ptr _exception;
+
+    private:
+        std::atomic<bool> _ready;
+        std::atomic<bool> _waiting;
+        Event_t _complete;
+    };
+
+    /**
+     * @brief Future of a task submitted to a ThreadPool
+     *
+     * @tparam T task result type
+     */
+    template <typename T>
+    class TaskFuture
+    {
+    public:
+        TaskFuture() : _pool(nullptr){};
+
+        /**
+         * @brief Whether the future refers to a submitted task
+         *
+         * @return true
+         * @return false
+         */
+        bool valid() const { return _state != nullptr; };
+
+        bool ready() const { return _state && _state->ready(); };
+
+        /**
+         * @brief Wait for the task to complete. Called from a worker of the same pool, other queued tasks are run
+         * while waiting.
+         *
+         */
+        void wait() const;
+
+        /**
+         * @brief Wait for the task and return its result, rethrowing any exception the task threw. The result is
+         * moved out so get should only be called once.
+         *
+         * @return T
+         */
+        T get()
+        {
+            if (!_state)
+            {
+                throw std::runtime_error("TaskFuture has no task!");
+            }
+            wait();
+            if (_state->_exception)
+            {
+                std::rethrow_exception(_state->_exception);
+            }
+            if constexpr (!std::is_void_v<T>)
+            {
+                return std::move(*_state->_value);
+            }
+        };
+
+    private:
+        friend class ThreadPool;
+
+        TaskFuture(std::shared_ptr<TaskState<T>> state, ThreadPool *pool) : _state(std::move(state)),
+                                                                           _pool(pool){};
+
+        std::shared_ptr<TaskState<T>> _state;
+        ThreadPool *_pool;
+    };
+
+    class ThreadPool
+    {
+    public:
+        using task_t = std::function<void()>;
+
+        /**
+         * @brief Construct a new Thread Pool, the workers are started immediately. Throws std::runtime_error if
+         * numWorkers is 0 or a worker fails to start.
+         *
+         * @param numWorkers
+         * @param stackSize worker stack size [bytes]
+         * @param priority worker priority
+         * @param pinWorkers pin worker i to core i % 2 rather than letting the scheduler place workers
+         * @param name worker name prefix, workers are named name0, name1, ...
+         */
+        ThreadPool(size_t numWorkers,
+                   size_t stackSize = 8192,
+                   int priority = 1,
+                   bool pinWorkers = false,
+                   std::string_view name = "pool") : _queues(numWorkers),
+                                                     _nextQueue(0),
+                                                     _stopping(false),
+                                                     _steals(0)
+        {
+            if (numWorkers == 0)
+            {
+                throw std::runtime_error("Thread pool must have at least one worker!");
+            }
+            for (size_t i = 0; i < numWorkers; i++)
+            {
+                _queues[i] = std::make_unique<queue_t>();
+            }
+
+            _workers.reserve(numWorkers);
+            for (size_t i = 0; i < numWorkers; i++)
+            {
+                const Thread::CORE_ID core = pinWorkers ? static_cast<Thread::CORE_ID>(i % 2) : Thread::CORE_ID::ANYCORE;
+                _workers.push_back(std::make_unique<Thread>([this, i](void *)
+                                                            { workerLoop(i); },
+                                                            nullptr,
+                                                            stackSize,
+                                                            priority,
+                                                            core,
+                                                            std::string(name) + std::to_string(i)));
+            }
+        };
+
+        /**
+         * @brief Finishes every queued task then stops the workers
+         *
+         */
+        ~ThreadPool()
+        {
+            _stopping.store(true);
+            for (size_t i = 0; i < _workers.size(); i++)
+            {
+                _pending.give();
+            }
+            _workers.clear(); // joins the workers
+        };
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * @brief Queue a callable to be run by a worker
+         *
+         * @tparam F callable taking no arguments
+         * @param f
+         * @return TaskFuture of the result of f
+         */
+        template <typename F>
+        auto submit(F &&f) -> TaskFuture<std::invoke_result_t<std::decay_t<F>>>
+        {
+            using result_t = std::invoke_result_t<std::decay_t<F>>;
+
+            auto state = std::make_shared<TaskState<result_t>>();
+            push([state, f = std::forward<F>(f)]() mutable
+                 { state->run(f); });
+            return TaskFuture<result_t>(std::move(state), this);
+        };
+
+        size_t getNumWorkers() const { return _workers.size(); };
+
+        /**
+         * @brief Number of tasks run by a worker that were stolen from another worker's deque
+         *
+         * @return uint32_t
+         */
+        uint32_t getSteals() const { return _steals.load(std::memory_order_relaxed); };
+
+        /**
+         * @brief Run one queued task on the calling thread if any is available, used to help while waiting
+         *
+         * @return true a task was run
+         * @return false no task was queued
+         */
+        bool runPendingTask()
+        {
+            task_t task;
+            if (!findTask(currentWorker(), task))
+            {
+                return false;
+            }
+            task();
+            return true;
+        };
+
+        /**
+         * @brief Whether the calling thread is a worker of this pool
+         *
+         * @return true
+         * @return false
+         */
+        bool onWorker() const { return workerPool() == this; };
+
+    private:
+        struct queue_t
+        {
+            Lock_t lock;
+            std::deque<task_t> tasks;
+        };
+
+        static constexpr size_t NO_WORKER = SIZE_MAX;
+
+        std::vector<std::unique_ptr<queue_t>> _queues;
+        std::vector<std::unique_ptr<Thread>> _workers;
+
+        /**
+         * @brief Counts queued tasks, idle workers block on it
+         *
+         */
+        Semaphore_t _pending;
+
+        std::atomic<size_t> _nextQueue;
+        std::atomic<bool> _stopping;
+        std::atomic<uint32_t> _steals;
+
+        static const ThreadPool *&workerPool()
+        {
+            thread_local const ThreadPool *pool = nullptr;
+            return pool;
+        };
+
+        static size_t &workerIndex()
+        {
+            thread_local size_t index = NO_WORKER;
+            return index;
+        };
+
+        size_t currentWorker() const { return onWorker() ? workerIndex() : NO_WORKER; };
+
+        void push(task_t task)
+        {
+            // a worker keeps the tasks it submits local, other threads spread tasks round robin
+            size_t index = currentWorker();
+            if (index == NO_WORKER)
+            {
+                index = _nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+            }
+            {
+                queue_t &queue = *_queues[index];
+                ScopedLock l(queue.lock);
+                queue.tasks.push_back(std::move(task));
+            }
+            _pending.give();
+        };
+
+        /**
+         * @brief Pop from the back of our own deque, otherwise steal from the front of another worker's deque
+         *
+         * @param self worker index, NO_WORKER if not called from a worker
+         * @param task
+         * @return true a task was found
+         * @return false
+         */
+        bool findTask(size_t self, task_t &task)
+        {
+            if (self != NO_WORKER)
+            {
+                queue_t &queue = *_queues[self];
+                ScopedLock l(queue.lock);
+                if (!queue.tasks.empty())
+                {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                    return true;
+                }
+            }
+
+            const size_t numQueues = _queues.size();
+            const size_t start = (self == NO_WORKER) ? 0 : self + 1;
+            for (size_t i = 0; i < numQueues; i++)
+            {
+                const size_t victim = (start + i) % numQueues;
+                if (victim == self)
+                {
+                    continue;
+                }
+                queue_t &queue = *_queues[victim];
+                ScopedLock l(queue.lock);
+                if (!queue.tasks.empty())
+                {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                    if (self != NO_WORKER)
+                    {
+                        _steals.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        void workerLoop(size_t index)
+        {
+            workerPool() = this;
+            workerIndex() = index;
+
+            task_t task;
+            while (true)
+            {
+                // every queued task gives one count, a count may be left over if a waiting thread ran the task
+                _pending.take();
+                if (findTask(index, task))
+                {
+                    task();
+                    task = nullptr;
+                }
+                else if (_stopping.load())
+                {
+                    return;
+                }
+            }
+        };
+    };
+
+    template <typename T>
+    void TaskFuture<T>::wait() const
+    {
+        if (!_state)
+        {
+            return;
+        }
+        // help from inside the pool so a task waiting on its subtasks can't starve the workers
+        if (_pool != nullptr && _pool->onWorker())
+        {
+            while (!_state->ready())
+            {
+                if (!_pool->runPendingTask())
+                {
+                    _state->wait();
+                }
+            }
+            return;
+        }
+        _state->wait();
+    };
+};
@@ -0,0 +1,94 @@
+#pragma once
+/**
+ * @file circularbuffer.h
+ * @brief Fixed capacity circular buffer with the capacity set at compile time, so it never allocates. Pushing to a
+ * full buffer overwrites the oldest element. Not thread safe, see RicCoreThread::SpscQueue for a queue between threads.
+ */
+#include <cstddef>
+#include <array>
+
+namespace RicCoreUtil
+{
+    template <typename T, size_t N>
+    class CircularBuffer
+    {
+        static_assert(N > 0, "CircularBuffer capacity must be non zero!");
+
+    public:
+        CircularBuffer() : _buffer(),
+                           _head(0),
+                           _size(0){};
+
+        /**
+         * @brief Push a new element, overwriting the oldest element if the buffer is full
+         *
+         * @param value
+         */
+        void push(const T &value)
+        {
+            _buffer[_head] = value;
+            _head = (_head + 1 == N) ? 0 : _head + 1;
+            if (_size < N)
+            {
+                ++_size;
+            }
+        };
+
+        /**
+         * @brief Element i in insertion order, 0 is the oldest element. Not bounds checked.
+         *
+         * @param i
+         * @return const T&
+         */
+        const T &operator[](size_t i) const
+        {
+            const size_t index = tail() + i;
+            return _buffer[(index >= N) ? index - N : index];
+        };
+
+        /**
+         * @brief Oldest element, the one overwritten by the next push when full. Not valid when empty.
+         *
+         * @return const T&
+         */
+        const T &oldest() const { return _buffer[tail()]; };
+
+        /**
+         * @brief Most recently pushed element. Not valid when empty.
+         *
+         * @return const T&
+         */
+        const T &newest() const { return _buffer[(_head == 0) ? N - 1 : _head - 1]; };
+
+        size_t size() const { return _size; };
+
+        bool empty() const { return _size == 0; };
+
+        bool full() const { return _size == N; };
+
+        static constexpr size_t capacity() { return N; };
+
+        /**
+         * @brief Position the next push is written to, wraps to 0 every N pushes
+         *
+         * @return size_t
+         */
+        size_t head() const { return _head; };
+
+        void clear()
+        {
+            _head = 0;
+            _size = 0;
+        };
+
+    private:
+        std::array<T, N> _buffer;
+        size_t _head;
+        size_t _size;
+
+        size_t tail() const
+        {
+            return (_size < N) ? 0 : _head;
+        };
+    };
+};
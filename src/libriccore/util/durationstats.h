@@ -0,0 +1,164 @@
+#pragma once
+/**
+ * @file durationstats.h
+ * @brief Fixed memory statistics accumulator for execution times. Tracks min, max and mean exactly and estimates
+ * percentiles from a log-linear histogram with two buckets per power of two, so percentiles are reported as the upper
+ * edge of the bucket they fall in (at most ~50% high, never low). Recording a sample is O(1) and never allocates.
+ */
+#include <cstdint>
+#include <array>
+#include <limits>
+
+namespace RicCoreUtil
+{
+    class DurationStats
+    {
+    public:
+        /**
+         * @brief Number of histogram buckets, two per power of two covering the full uint32 range
+         *
+         */
+        static constexpr size_t N_BUCKETS = 64;
+
+        /**
+         * @brief Summary of the recorded samples
+         *
+         */
+        struct summary_t
+        {
+            uint32_t count;
+            uint32_t min;
+            uint32_t max;
+            uint32_t mean;
+            uint32_t p99;
+        };
+
+        DurationStats()
+        {
+            reset();
+        };
+
+        /**
+         * @brief Record a new sample
+         *
+         * @param duration
+         */
+        void record(uint32_t duration)
+        {
+            ++_count;
+            _sum += duration;
+            if (duration < _min)
+            {
+                _min = duration;
+            }
+            if (duration > _max)
+            {
+                _max = duration;
+            }
+            ++_histogram[bucketIndex(duration)];
+        };
+
+        uint32_t count() const { return _count; };
+
+        uint32_t min() const { return _count ? _min : 0; };
+
+        uint32_t max() const { return _max; };
+
+        uint32_t mean() const { return _count ? static_cast<uint32_t>(_sum / _count) : 0; };
+
+        /**
+         * @brief Estimate the given percentile of the recorded samples
+         *
+         * @param p percentile in the range 0 to 1 e.g 0.99
+         * @return uint32_t upper edge of the bucket containing the percentile, clamped to the max sample
+         */
+        uint32_t percentile(float p) const
+        {
+            if (_count == 0)
+            {
+                return 0;
+            }
+
+            // rank of the sample we are looking for, rounded up so p99 of 100 samples is the 99th sample
+            uint32_t rank = static_cast<uint32_t>(p * static_cast<float>(_count) + 0.999f);
+            if (rank == 0)
+            {
+                rank = 1;
+            }
+
+            uint32_t cumulative = 0;
+            for (size_t i = 0; i < N_BUCKETS; i++)
+            {
+                cumulative += _histogram[i];
+                if (cumulative >= rank)
+                {
+                    const uint32_t upper = bucketUpperEdge(i);
+                    return (upper < _max) ? upper : _max;
+                }
+            }
+            return _max;
+        };
+
+        summary_t summary() const
+        {
+            return summary_t{count(), min(), max(), mean(), percentile(0.99f)};
+        };
+
+        void reset()
+        {
+            _count = 0;
+            _sum = 0;
+            _min = std::numeric_limits<uint32_t>::max();
+            _max = 0;
+            _histogram = {};
+        };
+
+    private:
+        uint32_t _count;
+        uint64_t _sum;
+        uint32_t _min;
+        uint32_t _max;
+        std::array<uint32_t, N_BUCKETS> _histogram;
+
+        /**
+         * @brief Values 0 and 1 get their own bucket, every other power of two is split into a lower and upper half
+         *
+         * @param value
+         * @return size_t
+         */
+        static size_t bucketIndex(uint32_t value)
+        {
+            if (value < 2)
+            {
+                return value;
+            }
+            size_t exponent = 0;
+            uint32_t v = value;
+            while (v >>= 1)
+            {
+                ++exponent;
+            }
+            const size_t half = (value >> (exponent - 1)) & 1;
+            return 2 * exponent + half;
+        };
+
+        /**
+         * @brief Largest value which maps to the given bucket
+         *
+         * @param index
+         * @return uint32_t
+         */
+        static uint32_t bucketUpperEdge(size_t index)
+        {
+            if (index < 2)
+            {
+                return static_cast<uint32_t>(index);
+            }
+            const size_t exponent = index / 2;
+            const size_t half = index % 2;
+            const uint64_t lower = (static_cast<uint64_t>(1) << exponent) + (static_cast<uint64_t>(half) << (exponent - 1));
+            const uint64_t upper = lower + (static_cast<uint64_t>(1) << (exponent - 1)) - 1;
+            return static_cast<uint32_t>(upper);
+        };
+    };
+};
@@ -0,0 +1,165 @@
+/**
+ * @brief Microbenchmark of the command dispatch cost of CommandHandler and StaticCommandHandler against the previous
+ * unordered_map lookup.
+ * Packets are deserialized up front so only the enabled check, lookup, function call and release of the packet are
+ * timed, the command functions themselves only increment a counter. The packet release is common to both so the
+ * difference between the two results is the dispatch saving.
+ *
+ */
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <bitset>
+
+#include <librnp/rnp_packet.h>
+#include <librnp/default_packets/simplecommandpacket.h>
+
+#include <libriccore/commands/commandhandler.h>
+#include <libriccore/commands/staticcommandhandler.h>
+#include <libriccore/platform/millis.h>
+
+enum class BENCH_COMMAND_ID : uint8_t
+{
+    COMMAND_0 = 0,
+    COMMAND_1 = 1,
+    COMMAND_2 = 2,
+    COMMAND_3 = 3,
+    COMMAND_4 = 4,
+    COMMAND_5 = 5,
+    COMMAND_6 = 6,
+    COMMAND_7 = 7
+};
+
+struct BenchSystem
+{
+    size_t commandCount = 0;
+};
+
+using BenchCommandHandler = CommandHandler<BenchSystem, BENCH_COMMAND_ID, 256>;
+
+static constexpr size_t numCommands = 8;
+static constexpr size_t numPackets = 200000;
+static constexpr size_t numRounds = 10;
+
+void benchCommand(BenchSystem &sys, const RnpPacketSerialized &packet)
+{
+    ++sys.commandCount;
+};
+
+using BenchCommandTable = CommandTable<Command<BENCH_COMMAND_ID::COMMAND_0, &benchCommand>,
+                                       Command<BENCH_COMMAND_ID::COMMAND_1, &benchCommand>,
+                                       Command<BENCH_COMMAND_ID::COMMAND_2, &benchCommand>,
+                                       Command<BENCH_COMMAND_ID::COMMAND_3, &benchCommand>,
+                                       Command<BENCH_COMMAND_ID::COMMAND_4, &benchCommand>,
+                                       Command<BENCH_COMMAND_ID::COMMAND_5, &benchCommand>,
+                                       Command<BENCH_COMMAND_ID::COMMAND_6, &benchCommand>,
+                                       Command<BENCH_COMMAND_ID::COMMAND_7, &benchCommand>>;
+
+using BenchStaticCommandHandler = StaticCommandHandler<BenchSystem, BENCH_COMMAND_ID, BenchCommandTable, 256>;
+
+std::vector<packetptr_t> generatePackets()
+{
+    std::vector<packetptr_t> packets;
+    packets.reserve(numPackets);
+    for (size_t i = 0; i < numPackets; i++)
+    {
+        SimpleCommandPacket commandPacket(static_cast<uint8_t>(i % numCommands), 0);
+        std::vector<uint8_t> serialized;
+        commandPacket.serialize(serialized);
+        packets.push_back(std::make_unique<RnpPacketSerialized>(serialized));
+    }
+    return packets;
+}
+
+template <typename F>
+double timeDispatch(BenchSystem &sys, F &&dispatch)
+{
+    double totalTime = 0;
+    sys.commandCount = 0;
+    for (size_t round = 0; round < numRounds; round++)
+    {
+        std::vector<packetptr_t> packets = generatePackets();
+        const auto start = std::chrono::steady_clock::now();
+        for (packetptr_t &packet : packets)
+        {
+            dispatch(std::move(packet));
+        }
+        const auto end = std::chrono::steady_clock::now();
+        totalTime += std::chrono::duration<double, std::nano>(end - start).count();
+    }
+    return totalTime / static_cast<double>(sys.commandCount);
+}
+
+int main()
+{
+    BenchSystem sys;
+
+    BenchCommandHandler::commandMap_t commandMap;
+    for (size_t i = 0; i < numCommands; i++)
+    {
+        commandMap[static_cast<BENCH_COMMAND_ID>(i)] = benchCommand;
+    }
+
+    BenchCommandHandler commandhandler(sys, commandMap, 2);
+    for (size_t i = 0; i < numCommands; i++)
+    {
+        commandhandler.enableCommands({static_cast<BENCH_COMMAND_ID>(i)});
+    }
+    auto callback = commandhandler.getCallback();
+
+    BenchStaticCommandHandler staticCommandhandler(sys, 2);
+    for (size_t i = 0; i < numCommands; i++)
+    {
+        staticCommandhandler.enableCommands({static_cast<BENCH_COMMAND_ID>(i)});
+    }
+    auto staticCallback = staticCommandhandler.getCallback();
+
+    // reference implementation of the unordered_map dispatch CommandHandler used previously
+    std::bitset<256> enabledCommands;
+    enabledCommands.set();
+    auto mapDispatch = [&](packetptr_t packetptr)
+    {
+        command_t cmd = CommandPacket::getCommand(*packetptr);
+        if (enabledCommands.test(cmd))
+        {
+            if (commandMap.count(static_cast<BENCH_COMMAND_ID>(cmd)))
+            {
+                commandMap.at(static_cast<BENCH_COMMAND_ID>(cmd))(sys, *packetptr);
+            }
+        }
+    };
+
+    // the reference with the execution time recording the handlers now do, to separate the cost of the timing
+    // from the cost of dispatch
+    uint64_t executionTime = 0;
+    auto timedMapDispatch = [&](packetptr_t packetptr)
+    {
+        command_t cmd = CommandPacket::getCommand(*packetptr);
+        if (enabledCommands.test(cmd))
+        {
+            if (commandMap.count(static_cast<BENCH_COMMAND_ID>(cmd)))
+            {
+                const uint32_t start = micros();
+                commandMap.at(static_cast<BENCH_COMMAND_ID>(cmd))(sys, *packetptr);
+                executionTime += micros() - start;
+            }
+        }
+    };
+
+    const double mapCost = timeDispatch(sys, mapDispatch);
+    const double timedMapCost = timeDispatch(sys, timedMapDispatch);
+    const double tableCost = timeDispatch(sys, [&](packetptr_t packetptr)
+                                          { callback(std::move(packetptr)); });
+    const double staticTableCost = timeDispatch(sys, [&](packetptr_t packetptr)
+                                                { staticCallback(std::move(packetptr)); });
+
+    std::cout << "commands dispatched: " << numPackets * numRounds << "\n";
+    std::cout << "unordered_map dispatch: " << mapCost << " ns/command\n";
+    std::cout << "  + execution timing:   " << timedMapCost << " ns/command\n";
+    std::cout << "CommandHandler:         " << tableCost << " ns/command\n";
+    std::cout << "StaticCommandHandler:   " << staticTableCost << " ns/command\n";
+
+    return 0;
+}
@@ -0,0 +1,281 @@
+/**
+ * @brief Checks the batch handling of CommandHandler. Every entry of a BATCH packet must be dispatched in order as a
+ * simple command packet, and a single BATCH_RESPONSE packet must report the result of every entry to the sender.
+ * Checks the token bucket rate limit and replay suppression, and that a deferred command rejected because the
+ * deferred queue is full doesn't use up its rate limit.
+ *
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include <librnp/rnp_packet.h>
+#include <librnp/rnp_header.h>
+#include <librnp/default_packets/simplecommandpacket.h>
+
+#include <libriccore/commands/commandhandler.h>
+#include <libriccore/platform/riccorethread_types.h>
+
+enum class TEST_COMMAND_ID : uint8_t
+{
+    A = 0,
+    B = 1,
+    DISABLED = 2,
+    UNKNOWN = 3,
+    DEFERRED = 4
+};
+
+using Command = TEST_COMMAND_ID;
+
+/**
+ * @brief Records the packets sent by the command handler
+ *
+ */
+struct MockNetworkManager
+{
+    std::vector<std::vector<uint8_t>> sent;
+
+    uint8_t getAddress() { return 2; };
+
+    void sendPacket(RnpPacket &packet)
+    {
+        std::vector<uint8_t> buf;
+        packet.serialize(buf);
+        sent.push_back(std::move(buf));
+    };
+};
+
+struct MockSystem
+{
+    MockNetworkManager networkmanager;
+    std::vector<std::pair<uint8_t, uint32_t>> calls; // (command, arg) of every executed command
+    bool allSimple = true; // every command function saw a simple command packet
+    std::atomic<int> deferredCalls{0};
+    std::atomic<bool> deferredStarted{false};
+    RicCoreThread::Event_t deferredGate; // deferred commands block until set
+};
+
+using TestCommandHandler = CommandHandler<MockSystem, TEST_COMMAND_ID, 256>;
+
+void recordCommand(MockSystem &sys, const RnpPacketSerialized &packet)
+{
+    SimpleCommandPacket command(packet);
+    sys.calls.push_back({command.command, command.arg});
+    sys.allSimple &= (packet.header.type == 0);
+}
+
+void deferredCommand(MockSystem &sys, const RnpPacketSerialized &packet)
+{
+    // runs on the deferred worker
+    sys.deferredStarted = true;
+    sys.deferredGate.wait();
+    ++sys.deferredCalls;
+}
+
+static bool check(bool condition, const std::string &description)
+{
+    std::cout << (condition ? "  ok   " : "  FAIL ") << description << std::endl;
+    return condition;
+}
+
+static void addEntry(std::vector<uint8_t> &batch, Command command, uint32_t arg)
+{
+    batch.push_back(static_cast<uint8_t>(command));
+    uint8_t argBytes[sizeof(arg)];
+    std::memcpy(argBytes, &arg, sizeof(arg));
+    batch.insert(batch.end(), argBytes, argBytes + sizeof(arg));
+}
+
+static bool testBatch()
+{
+    std::cout << "batch" << std::endl;
+
+    MockSystem sys;
+    TestCommandHandler commandhandler(sys,
+                                      {{Command::A, recordCommand},
+                                       {Command::B, recordCommand},
+                                       {Command::DISABLED, recordCommand},
+                                       {Command::DEFERRED, deferredCommand}},
+                                      2,
+                                      {Command::A, Command::B, Command::UNKNOWN, Command::DEFERRED});
+    commandhandler.deferCommands({Command::DEFERRED});
+    sys.deferredGate.set();
+    auto callback = commandhandler.getCallback();
+
+    std::vector<std::pair<Command, uint32_t>> entries{{Command::A, 10},
+                                                      {Command::DISABLED, 0},
+                                                      {Command::UNKNOWN, 0},
+                                                      {Command::DEFERRED, 30},
+                                                      {Command::B, 11}};
+
+    RnpHeader header;
+    header.type = static_cast<uint8_t>(TestCommandHandler::PACKET_TYPES::BATCH);
+    header.packet_len = static_cast<uint16_t>(entries.size() * SimpleCommandPacket::size());
+    header.uid = 77;
+    header.source = 5;
+    header.source_service = 3;
+    header.destination_service = 2;
+
+    std::vector<uint8_t> batch;
+    header.serialize(batch);
+    for (const auto &[command, arg] : entries)
+    {
+        addEntry(batch, command, arg);
+    }
+    callback(std::make_unique<RnpPacketSerialized>(batch));
+
+    bool passed = true;
+    passed &= check(sys.calls.size() == 2 && sys.calls[0] == std::make_pair<uint8_t, uint32_t>(0, 10) && sys.calls[1] == std::make_pair<uint8_t, uint32_t>(1, 11),
+                    "enabled entries executed in order with their arguments");
+    passed &= check(sys.allSimple, "entries dispatched as simple command packets");
+
+    commandhandler.update();
+
+    std::vector<const std::vector<uint8_t> *> responses;
+    for (const std::vector<uint8_t> &packet : sys.networkmanager.sent)
+    {
+        if (RnpHeader(packet).type == static_cast<uint8_t>(TestCommandHandler::PACKET_TYPES::BATCH_RESPONSE))
+        {
+            responses.push_back(&packet);
+        }
+    }
+    if (!check(responses.size() == 1, "single batch response sent"))
+    {
+        return false;
+    }
+
+    const std::vector<uint8_t> &response = *responses[0];
+    const RnpHeader responseHeader(response);
+    passed &= check(responseHeader.uid == 77 && responseHeader.destination == 5 && responseHeader.destination_service == 3 && responseHeader.source_service == 2,
+                    "response addressed to the sender with the batch uid");
+
+    using RESULT = TestCommandHandler::BATCH_RESULT;
+    const std::vector<uint8_t> expected{static_cast<uint8_t>(entries.size()), 0,
+                                        0, static_cast<uint8_t>(RESULT::EXECUTED),
+                                        2, static_cast<uint8_t>(RESULT::DISABLED),
+                                        3, static_cast<uint8_t>(RESULT::UNKNOWN),
+                                        4, static_cast<uint8_t>(RESULT::DEFERRED),
+                                        1, static_cast<uint8_t>(RESULT::EXECUTED)};
+    const std::vector<uint8_t> payload(response.begin() + RnpHeader::size(), response.end());
+    passed &= check(payload == expected, "response holds the result of every entry");
+    return passed;
+}
+
+static packetptr_t makeCommand(Command command, uint16_t uid, uint8_t source = 5)
+{
+    SimpleCommandPacket commandPacket(static_cast<uint8_t>(command), 0);
+    commandPacket.header.uid = uid;
+    commandPacket.header.source = source;
+    std::vector<uint8_t> serialized;
+    commandPacket.serialize(serialized);
+    return std::make_unique<RnpPacketSerialized>(serialized);
+}
+
+static bool testRateLimit()
+{
+    std::cout << "rate_limit" << std::endl;
+
+    MockSystem sys;
+    TestCommandHandler commandhandler(sys, {{Command::A, recordCommand}}, 2, {Command::A});
+    auto callback = commandhandler.getCallback();
+    commandhandler.setRateLimit(Command::A, 3, 50);
+
+    uint16_t uid = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        callback(makeCommand(Command::A, uid++));
+    }
+
+    bool passed = true;
+    passed &= check(sys.calls.size() == 3 && commandhandler.getRejectionCounts().rate_limited == 7, "burst of 3 allowed, rest rate limited");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(110));
+    for (int i = 0; i < 10; i++)
+    {
+        callback(makeCommand(Command::A, uid++));
+    }
+    passed &= check(sys.calls.size() == 5, "one token regained per interval");
+    return passed;
+}
+
+static bool testDuplicateWindow()
+{
+    std::cout << "duplicate_window" << std::endl;
+
+    MockSystem sys;
+    TestCommandHandler commandhandler(sys, {{Command::A, recordCommand}}, 2, {Command::A});
+    auto callback = commandhandler.getCallback();
+    commandhandler.setDuplicateWindow(100);
+
+    callback(makeCommand(Command::A, 500));
+    callback(makeCommand(Command::A, 500));
+    callback(makeCommand(Command::A, 501));
+    callback(makeCommand(Command::A, 500, 6));
+
+    bool passed = true;
+    passed &= check(sys.calls.size() == 3 && commandhandler.getRejectionCounts().duplicate == 1, "replay of the same source and uid dropped");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    callback(makeCommand(Command::A, 500));
+    passed &= check(sys.calls.size() == 4, "uid accepted again after the window");
+    return passed;
+}
+
+static bool waitFor(const std::atomic<int> &value, int expected)
+{
+    for (int i = 0; i < 1000 && value < expected; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return value >= expected;
+}
+
+static bool testQueueFullRefund()
+{
+    std::cout << "queue_full_refund" << std::endl;
+
+    MockSystem sys;
+    TestCommandHandler commandhandler(sys, {{Command::DEFERRED, deferredCommand}}, 2, {Command::DEFERRED});
+    auto callback = commandhandler.getCallback();
+    commandhandler.deferCommands({Command::DEFERRED});
+    commandhandler.configureDeferredWorker(8192, 0, RicCoreThread::Thread::CORE_ID::ANYCORE, 1);
+    commandhandler.setRateLimit(Command::DEFERRED, 3, 1000000);
+
+    // the first command blocks the worker, the second fills the queue and the third is rejected
+    callback(makeCommand(Command::DEFERRED, 1));
+    while (!sys.deferredStarted)
+    {
+        std::this_thread::yield();
+    }
+    callback(makeCommand(Command::DEFERRED, 2));
+    callback(makeCommand(Command::DEFERRED, 3));
+
+    bool passed = true;
+    passed &= check(commandhandler.getRejectionCounts().queue_full == 1, "command rejected with the queue full");
+
+    sys.deferredGate.set();
+    passed &= check(waitFor(sys.deferredCalls, 2), "queued commands executed");
+
+    callback(makeCommand(Command::DEFERRED, 4));
+    passed &= check(commandhandler.getRejectionCounts().rate_limited == 0, "rejected command didn't use a token");
+    passed &= check(waitFor(sys.deferredCalls, 3), "command executed with the refunded token");
+    return passed;
+}
+
+int main()
+{
+    bool passed = true;
+    passed &= testBatch();
+    passed &= testRateLimit();
+    passed &= testDuplicateWindow();
+    passed &= testQueueFullRefund();
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+/**
+ * @brief Benchmark of the filtering module. The legacy MovingAvg is compared against MovingAverage over several window
+ * sizes on the same noisy signal, checking both agree once the window has filled, then the cost per sample of the
+ * other filters is reported. Finally a multi channel signal is filtered by a filter instance per channel and by the
+ * structure of arrays filter banks, reporting the cost per channel sample.
+ *
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <string>
+
+#include <libriccore/filtering/movingAvg.h>
+#include <libriccore/filtering/movingaverage.h>
+#include <libriccore/filtering/exponentialmovingaverage.h>
+#include <libriccore/filtering/medianfilter.h>
+#include <libriccore/filtering/iirfilter.h>
+#include <libriccore/filtering/filterbank.h>
+
+static constexpr size_t numSamples = 1000000;
+static constexpr size_t numChannels = 32;
+
+static volatile float sink; // prevent the filter output being optimized away
+
+static std::vector<float> generateSignal()
+{
+    std::mt19937 rng(42);
+    std::normal_distribution<float> noise(0.f, 0.5f);
+    std::vector<float> signal(numSamples);
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        signal[i] = std::sin(static_cast<float>(i) * 0.01f) + noise(rng);
+    }
+    return signal;
+}
+
+/**
+ * @brief Time a callable over the whole signal
+ *
+ * @return double [ns/sample]
+ */
+template <typename F>
+static double timeFilter(const std::vector<float> &signal, F &&filter)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (float sample : signal)
+    {
+        sink = filter(sample);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(signal.size());
+}
+
+static void printResult(const std::string &name, double nsPerSample)
+{
+    std::cout << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << nsPerSample << " ns/sample" << std::endl;
+}
+
+/**
+ * @brief Compare MovingAvg against MovingAverage for a window size, returns false if the outputs disagree
+ *
+ */
+template <size_t N>
+static bool compareMovingAverage(const std::vector<float> &signal)
+{
+    MovingAvg legacy(N);
+    RicCoreFiltering::MovingAverage<float, N> movingAverage;
+
+    const double legacyTime = timeFilter(signal, [&legacy](float sample)
+                                         { legacy.update(sample); return legacy.getAvg(); });
+    const double newTime = timeFilter(signal, [&movingAverage](float sample)
+                                      { return movingAverage.update(sample); });
+
+    printResult("MovingAvg N=" + std::to_string(N), legacyTime);
+    printResult("MovingAverage N=" + std::to_string(N), newTime);
+    std::cout << "  speedup: " << std::setprecision(1) << legacyTime / newTime << "x" << std::endl;
+
+    // check agreement, MovingAvg divides by N before the window fills so only compare full windows
+    legacy = MovingAvg(N);
+    movingAverage.reset();
+    float maxError = 0;
+    for (size_t i = 0; i < signal.size(); i++)
+    {
+        legacy.update(signal[i]);
+        const float avg = movingAverage.update(signal[i]);
+        if (i + 1 >= N)
+        {
+            maxError = std::max(maxError, std::abs(avg - legacy.getAvg()));
+        }
+    }
+    std::cout << "  max difference: " << std::scientific << std::setprecision(2) << maxError << std::endl;
+    return maxError < 1e-4f;
+}
+
+/**
+ * @brief Time a per channel filter array and a filter bank over the frame interleaved multi channel signal, returns
+ * false if the outputs disagree
+ *
+ */
+template <typename FILTER, typename BANK>
+static bool compareBank(const std::string &name, const std::vector<float> &signal, std::vector<FILTER> filters, BANK bank)
+{
+    const size_t numFrames = signal.size() / numChannels;
+    std::vector<float> filterOutput(signal.size());
+    std::vector<float> bankOutput(signal.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < numFrames; frame++)
+    {
+        for (size_t c = 0; c < numChannels; c++)
+        {
+            filterOutput[frame * numChannels + c] = filters[c].update(signal[frame * numChannels + c]);
+        }
+    }
+    const double filterTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    bank.updateBlock(signal.data(), bankOutput.data(), numFrames);
+    const double bankTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    const double channelSamples = static_cast<double>(numFrames * numChannels);
+    printResult(name + " x" + std::to_string(numChannels), filterTime / channelSamples);
+    printResult(name + "Bank<" + std::to_string(numChannels) + ">", bankTime / channelSamples);
+    std::cout << "  speedup: " << std::fixed << std::setprecision(1) << filterTime / bankTime << "x" << std::endl;
+
+    float maxError = 0;
+    for (size_t i = 0; i < signal.size(); i++)
+    {
+        maxError = std::max(maxError, std::abs(filterOutput[i] - bankOutput[i]));
+    }
+    std::cout << "  max difference: " << std::scientific << std::setprecision(2) << maxError << std::endl;
+    return maxError < 1e-4f;
+}
+
+int main()
+{
+    const std::vector<float> signal = generateSignal();
+    bool passed = true;
+
+    passed &= compareMovingAverage<8>(signal);
+    passed &= compareMovingAverage<32>(signal);
+    passed &= compareMovingAverage<128>(signal);
+
+    RicCoreFiltering::ExponentialMovingAverage<float> ema(RicCoreFiltering::ExponentialMovingAverage<float>::alphaFromCutoff(5, 1000));
+    printResult("ExponentialMovingAverage", timeFilter(signal, [&ema](float sample)
+                                                       { return ema.update(sample); }));
+
+    RicCoreFiltering::MedianFilter<float, 9> median;
+    printResult("MedianFilter N=9", timeFilter(signal, [&median](float sample)
+                                               { return median.update(sample); }));
+
+    auto firstOrder = RicCoreFiltering::FirstOrderIIR<float>::lowPass(5, 1000);
+    printResult("FirstOrderIIR low pass", timeFilter(signal, [&firstOrder](float sample)
+                                                     { return firstOrder.update(sample); }));
+
+    auto biquad = RicCoreFiltering::Biquad<float>::lowPass(5, 1000);
+    printResult("Biquad low pass", timeFilter(signal, [&biquad](float sample)
+                                              { return biquad.update(sample); }));
+
+    // sanity check the filter dc gain
+    biquad.reset();
+    firstOrder.reset();
+    for (size_t i = 0; i < 10000; i++)
+    {
+        biquad.update(1);
+        firstOrder.update(1);
+    }
+    if (std::abs(biquad.get() - 1) > 1e-3f || std::abs(firstOrder.get() - 1) > 1e-3f)
+    {
+        std::cout << "IIR dc gain incorrect!" << std::endl;
+        passed = false;
+    }
+
+    // multi channel signal, the same signal offset by a dc level per channel
+    std::vector<float> multiChannelSignal(signal.size() / numChannels * numChannels);
+    for (size_t i = 0; i < multiChannelSignal.size(); i++)
+    {
+        multiChannelSignal[i] = signal[i] + static_cast<float>(i % numChannels);
+    }
+
+    passed &= compareBank("MovingAverage<16>",
+                          multiChannelSignal,
+                          std::vector<RicCoreFiltering::MovingAverage<float, 16>>(numChannels),
+                          RicCoreFiltering::MovingAverageBank<numChannels, 16>());
+
+    const float alpha = RicCoreFiltering::ExponentialMovingAverage<float>::alphaFromCutoff(5, 1000);
+    passed &= compareBank("ExponentialMovingAverage",
+                          multiChannelSignal,
+                          std::vector<RicCoreFiltering::ExponentialMovingAverage<float>>(numChannels, RicCoreFiltering::ExponentialMovingAverage<float>(alpha)),
+                          RicCoreFiltering::ExponentialMovingAverageBank<numChannels>(alpha));
+
+    const auto prototype = RicCoreFiltering::Biquad<float>::lowPass(5, 1000);
+    passed &= compareBank("Biquad",
+                          multiChannelSignal,
+                          std::vector<RicCoreFiltering::Biquad<float>>(numChannels, prototype),
+                          RicCoreFiltering::BiquadBank<numChannels>(prototype));
+
+    // single channel bank matches the single channel filter
+    RicCoreFiltering::BiquadBank<1> singleChannel(prototype);
+    biquad.reset();
+    for (float sample : signal)
+    {
+        if (singleChannel.update(sample) != biquad.update(sample))
+        {
+            std::cout << "Single channel bank output incorrect!" << std::endl;
+            passed = false;
+            break;
+        }
+    }
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+/**
+ * @brief Benchmark of the state transition cost of StateMachine (heap allocated states) against
+ * StaticStateMachine (states constructed in place). The benchmark states hide/override initialize and exit
+ * so the SystemStatus logging, which is identical for both engines, doesn't swamp the measurement.
+ *
+ */
+#include <iostream>
+#include <chrono>
+#include <memory>
+
+#include <libriccore/fsm/statemachine.h>
+#include <libriccore/fsm/staticstatemachine.h>
+#include <libriccore/systemstatus/systemstatus.h>
+
+enum class BENCH_SYSTEM_FLAGS : uint32_t
+{
+    STATE_A = (1 << 0),
+    STATE_B = (1 << 1)
+};
+
+using Flags = BENCH_SYSTEM_FLAGS;
+
+static constexpr size_t numTransitions = 1000000;
+
+SystemStatus<Flags> systemstatus;
+size_t transitionCount = 0;
+
+// Dynamic states
+class DynamicB;
+
+class DynamicA : public State<Flags>
+{
+public:
+    DynamicA() : State(Flags::STATE_A, systemstatus){};
+    void initialize() override { ++transitionCount; };
+    std::unique_ptr<State<Flags>> update() override;
+    void exit() override{};
+};
+
+class DynamicB : public State<Flags>
+{
+public:
+    DynamicB() : State(Flags::STATE_B, systemstatus){};
+    void initialize() override { ++transitionCount; };
+    std::unique_ptr<State<Flags>> update() override { return std::make_unique<DynamicA>(); };
+    void exit() override{};
+};
+
+std::unique_ptr<State<Flags>> DynamicA::update() { return std::make_unique<DynamicB>(); };
+
+// Static states
+struct BenchContext
+{
+    SystemStatus<Flags> &systemstatus;
+};
+
+class StaticB;
+
+class StaticA : public StaticState<Flags>
+{
+public:
+    StaticA(BenchContext &context) : StaticState(Flags::STATE_A, context.systemstatus){};
+    void initialize() { ++transitionCount; };
+    StaticStateTransition update() { return StaticStateTransition::to<StaticB>(); };
+    void exit(){};
+};
+
+class StaticB : public StaticState<Flags>
+{
+public:
+    StaticB(BenchContext &context) : StaticState(Flags::STATE_B, context.systemstatus){};
+    void initialize() { ++transitionCount; };
+    StaticStateTransition update() { return StaticStateTransition::to<StaticA>(); };
+    void exit(){};
+};
+
+template <typename F>
+double timeTransitions(F &&f)
+{
+    transitionCount = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numTransitions; i++)
+    {
+        f();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(transitionCount);
+}
+
+int main()
+{
+    StateMachine<Flags> dynamicStatemachine;
+    dynamicStatemachine.initalize(std::make_unique<DynamicA>());
+
+    BenchContext context{systemstatus};
+    StaticStateMachine<Flags, BenchContext, StaticA, StaticB> staticStatemachine(context);
+    staticStatemachine.initalize<StaticA>();
+
+    const double dynamicCost = timeTransitions([&]()
+                                               { dynamicStatemachine.update(); });
+    const double staticCost = timeTransitions([&]()
+                                              { staticStatemachine.update(); });
+
+    std::cout << "transitions: " << numTransitions << "\n";
+    std::cout << "StateMachine:       " << dynamicCost << " ns/transition\n";
+    std::cout << "StaticStateMachine: " << staticCost << " ns/transition\n";
+    std::cout << "sizeof(StaticStateMachine): " << sizeof(staticStatemachine) << " bytes\n";
+
+    return 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * @brief Checks the entry and exit order of SuperState and OrthogonalState, and that the composite state's flag is
+ * raised whenever any nested state flag is. A nested state transition must not touch the parent, and a parent update
+ * returning a state must exit the nested states before the parent.
+ *
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <libriccore/fsm/statemachine.h>
+#include <libriccore/fsm/superstate.h>
+#include <libriccore/fsm/orthogonalstate.h>
+#include <libriccore/systemstatus/systemstatus.h>
+
+enum class TEST_FLAGS : uint32_t
+{
+    PARENT = (1 << 0),
+    CHILD_A = (1 << 1),
+    CHILD_B = (1 << 2),
+    REGION_0 = (1 << 3),
+    REGION_1 = (1 << 4),
+    IDLE = (1 << 5)
+};
+
+using Flags = TEST_FLAGS;
+
+SystemStatus<Flags> systemstatus;
+std::vector<std::string> events;
+bool flagsConsistent = true;
+bool preempt = false;
+
+/**
+ * @brief Leaf state recording its entry and exit, and checking the parent flag is raised while it is active
+ *
+ */
+class LeafState : public State<Flags>
+{
+public:
+    LeafState(Flags id, std::string name, Flags parent, Flags next) : State(id, systemstatus),
+                                                                      _name(std::move(name)),
+                                                                      _parent(parent),
+                                                                      _next(next){};
+
+    void initialize() override
+    {
+        flagsConsistent &= systemstatus.flagSet(_parent);
+        State::initialize();
+        events.push_back("enter " + _name);
+    };
+
+    std::unique_ptr<State<Flags>> update() override
+    {
+        if (_next == stateID)
+        {
+            return nullptr;
+        }
+        return std::make_unique<LeafState>(_next, _next == Flags::CHILD_A ? "a" : "b", _parent, _next);
+    };
+
+    void exit() override
+    {
+        State::exit();
+        flagsConsistent &= systemstatus.flagSet(_parent);
+        events.push_back("exit " + _name);
+    };
+
+private:
+    const std::string _name;
+    const Flags _parent;
+    const Flags _next;
+};
+
+class IdleState : public State<Flags>
+{
+public:
+    IdleState() : State(Flags::IDLE, systemstatus){};
+
+    void initialize() override
+    {
+        State::initialize();
+        events.push_back("enter idle");
+    };
+};
+
+class Parent : public SuperState<Flags>
+{
+public:
+    Parent() : SuperState(Flags::PARENT, systemstatus){};
+
+    void initialize() override
+    {
+        events.push_back("enter parent");
+        SuperState::initialize();
+    };
+
+    void exit() override
+    {
+        SuperState::exit();
+        flagsConsistent &= !systemstatus.flagSetOr(Flags::CHILD_A, Flags::CHILD_B);
+        events.push_back("exit parent");
+    };
+
+protected:
+    std::unique_ptr<State<Flags>> initialSubstate() override
+    {
+        // child a transitions to child b on its first update, which then stays
+        return std::make_unique<LeafState>(Flags::CHILD_A, "a", Flags::PARENT, Flags::CHILD_B);
+    };
+
+    std::unique_ptr<State<Flags>> parentUpdate() override
+    {
+        return preempt ? std::make_unique<IdleState>() : nullptr;
+    };
+};
+
+class Orthogonal : public OrthogonalState<Flags>
+{
+public:
+    Orthogonal() : OrthogonalState(Flags::PARENT, systemstatus){};
+
+    void initialize() override
+    {
+        events.push_back("enter orthogonal");
+        OrthogonalState::initialize();
+    };
+
+    void exit() override
+    {
+        OrthogonalState::exit();
+        flagsConsistent &= !systemstatus.flagSetOr(Flags::REGION_0, Flags::REGION_1);
+        events.push_back("exit orthogonal");
+    };
+
+protected:
+    std::vector<std::unique_ptr<State<Flags>>> initialRegionStates() override
+    {
+        std::vector<std::unique_ptr<State<Flags>>> states;
+        states.push_back(std::make_unique<LeafState>(Flags::REGION_0, "r0", Flags::PARENT, Flags::REGION_0));
+        states.push_back(std::make_unique<LeafState>(Flags::REGION_1, "r1", Flags::PARENT, Flags::REGION_1));
+        return states;
+    };
+
+    std::unique_ptr<State<Flags>> parentUpdate() override
+    {
+        return preempt ? std::make_unique<IdleState>() : nullptr;
+    };
+};
+
+static bool check(bool condition, const std::string &description)
+{
+    std::cout << (condition ? "  ok   " : "  FAIL ") << description << std::endl;
+    return condition;
+}
+
+static bool checkEvents(const std::vector<std::string> &expected, const std::string &description)
+{
+    bool match = (events == expected);
+    if (!match)
+    {
+        std::cout << "  got:";
+        for (const std::string &event : events)
+        {
+            std::cout << " [" << event << "]";
+        }
+        std::cout << std::endl;
+    }
+    events.clear();
+    return check(match, description);
+}
+
+static bool testSuperState()
+{
+    std::cout << "super_state" << std::endl;
+    bool passed = true;
+    flagsConsistent = true;
+    preempt = false;
+
+    StateMachine<Flags> statemachine;
+    statemachine.initalize(std::make_unique<Parent>());
+    passed &= checkEvents({"enter parent", "enter a"}, "parent entered before child");
+    passed &= check(systemstatus.flagSetAnd(Flags::PARENT, Flags::CHILD_A), "parent and child flags raised");
+
+    statemachine.update();
+    passed &= checkEvents({"exit a", "enter b"}, "substate transition doesn't exit the parent");
+    passed &= check(systemstatus.flagSetAnd(Flags::PARENT, Flags::CHILD_B) && !systemstatus.flagSet(Flags::CHILD_A), "child flags follow the substate");
+
+    preempt = true;
+    statemachine.update();
+    passed &= checkEvents({"exit b", "exit parent", "enter idle"}, "pre-empt exits child then parent");
+    passed &= check(!systemstatus.flagSetOr(Flags::PARENT, Flags::CHILD_A, Flags::CHILD_B), "parent and child flags removed");
+
+    statemachine.exit();
+    events.clear();
+    passed &= check(flagsConsistent, "parent flag raised whenever a child flag is");
+    return passed;
+}
+
+static bool testOrthogonalState()
+{
+    std::cout << "orthogonal_state" << std::endl;
+    bool passed = true;
+    flagsConsistent = true;
+    preempt = false;
+
+    StateMachine<Flags> statemachine;
+    statemachine.initalize(std::make_unique<Orthogonal>());
+    passed &= checkEvents({"enter orthogonal", "enter r0", "enter r1"}, "regions entered in order after the parent");
+    passed &= check(systemstatus.flagSetAnd(Flags::PARENT, Flags::REGION_0, Flags::REGION_1), "parent and region flags raised");
+
+    statemachine.update();
+    passed &= checkEvents({}, "region update without transition has no entry or exit");
+
+    preempt = true;
+    statemachine.update();
+    passed &= checkEvents({"exit r1", "exit r0", "exit orthogonal", "enter idle"}, "regions exited in reverse order before the parent");
+    passed &= check(!systemstatus.flagSetOr(Flags::PARENT, Flags::REGION_0, Flags::REGION_1), "parent and region flags removed");
+
+    statemachine.exit();
+    events.clear();
+    passed &= check(flagsConsistent, "parent flag raised whenever a region flag is");
+    return passed;
+}
+
+int main()
+{
+    bool passed = true;
+    passed &= testSuperState();
+    passed &= testOrthogonalState();
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
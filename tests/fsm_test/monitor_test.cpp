@@ -0,0 +1,236 @@
+/**
+ * @brief Checks the states recorded by StateTrace. States are recorded and serialized by the index of their flag
+ * bit, so a state flag above bit 31 of a 64 bit flag enum must keep its own index rather than being truncated.
+ * StateProfiler serializes its states by the same index. The states of a wide flag enum are already bit indices, so
+ * they are indexed by value and state zero must stay distinct from having no state.
+ *
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <cstring>
+
+#include <libriccore/fsm/statemachine.h>
+#include <libriccore/fsm/statetrace.h>
+#include <libriccore/fsm/stateprofiler.h>
+#include <libriccore/systemstatus/systemstatus.h>
+
+enum class HIGH_BIT_STATES : uint64_t
+{
+    LOW = (1ULL << 0),
+    HIGH = (1ULL << 40),
+    TOP = (1ULL << 63)
+};
+
+using States = HIGH_BIT_STATES;
+
+SystemStatus<States> systemstatus;
+
+enum class WIDE_STATES : uint8_t
+{
+    FIRST = 0,
+    SECOND = 1,
+    LAST = 127
+};
+
+template <>
+struct WideFlags<WIDE_STATES> : std::integral_constant<size_t, 128>
+{
+};
+
+SystemStatus<WIDE_STATES> widesystemstatus;
+
+/**
+ * @brief State which transitions to the next state given on its first update
+ *
+ */
+class StepState : public State<States>
+{
+public:
+    StepState(States id, States next) : State(id, systemstatus),
+                                        _next(next){};
+
+    std::unique_ptr<State<States>> update() override
+    {
+        if (_next == stateID)
+        {
+            return nullptr;
+        }
+        return std::make_unique<StepState>(_next, _next == States::HIGH ? States::TOP : _next);
+    };
+
+private:
+    const States _next;
+};
+
+/**
+ * @brief Wide flag state which transitions FIRST -> SECOND -> LAST, one transition per update
+ *
+ */
+class WideStepState : public State<WIDE_STATES>
+{
+public:
+    WideStepState(WIDE_STATES id) : State(id, widesystemstatus){};
+
+    std::unique_ptr<State<WIDE_STATES>> update() override
+    {
+        switch (stateID)
+        {
+        case WIDE_STATES::FIRST:
+            return std::make_unique<WideStepState>(WIDE_STATES::SECOND);
+        case WIDE_STATES::SECOND:
+            return std::make_unique<WideStepState>(WIDE_STATES::LAST);
+        default:
+            return nullptr;
+        }
+    };
+};
+
+static bool check(bool condition, const std::string &description)
+{
+    std::cout << (condition ? "  ok   " : "  FAIL ") << description << std::endl;
+    return condition;
+}
+
+template <typename T>
+static T readBytes(const std::vector<uint8_t> &buf, size_t offset)
+{
+    T value;
+    std::memcpy(&value, buf.data() + offset, sizeof(T));
+    return value;
+}
+
+static bool testHighFlagStates()
+{
+    std::cout << "high_flag_states" << std::endl;
+
+    using trace_t = StateTrace<States>;
+    trace_t trace;
+    StateMachine<States> statemachine;
+    statemachine.addMonitor(trace);
+
+    // low -> high -> top
+    statemachine.initalize(std::make_unique<StepState>(States::LOW, States::HIGH));
+    statemachine.update();
+    statemachine.update();
+
+    std::array<trace_t::event_t, 64> events;
+    const size_t count = trace.snapshot(events);
+
+    bool passed = true;
+    passed &= check(count == 3, "every transition recorded");
+    passed &= check(events[0].from == trace_t::NO_STATE && events[0].to == 0, "initial transition has no exited state");
+    passed &= check(events[1].from == 0 && events[1].to == 40 && events[2].from == 40 && events[2].to == 63, "states above bit 31 keep their index");
+    passed &= check(trace.getStats(States::HIGH).entries == 1 && trace.getStats(States::TOP).entries == 1 && trace.getStats(States::LOW).entries == 1,
+                    "stats kept per state");
+
+    std::vector<uint8_t> buf;
+    trace.serialize(buf);
+    const size_t statesOffset = sizeof(uint32_t) + count * trace_t::EVENT_SIZE;
+    const size_t statEntrySize = sizeof(trace_t::stateIndex_t) + sizeof(trace_t::state_stats_t);
+    passed &= check(buf.size() == statesOffset + sizeof(uint32_t) + 3 * statEntrySize, "serialized size");
+    passed &= check(readBytes<uint16_t>(buf, sizeof(uint32_t) + 2 * trace_t::EVENT_SIZE + sizeof(uint64_t)) == 40 &&
+                        readBytes<uint16_t>(buf, sizeof(uint32_t) + 2 * trace_t::EVENT_SIZE + sizeof(uint64_t) + sizeof(uint16_t)) == 63,
+                    "serialized event holds the state indices");
+    passed &= check(readBytes<uint32_t>(buf, statesOffset) == 3 &&
+                        readBytes<uint16_t>(buf, statesOffset + sizeof(uint32_t) + statEntrySize) == 40 &&
+                        readBytes<uint16_t>(buf, statesOffset + sizeof(uint32_t) + 2 * statEntrySize) == 63,
+                    "serialized stats hold the state indices");
+
+    statemachine.exit();
+    return passed;
+}
+
+static bool testProfilerHighFlagStates()
+{
+    std::cout << "profiler_high_flag_states" << std::endl;
+
+    StateProfiler<States> profiler(systemstatus, States::LOW);
+    profiler.onUpdate(States::HIGH, 10);
+    profiler.onUpdate(States::TOP, 20);
+
+    std::vector<uint8_t> buf;
+    profiler.serialize(buf);
+    const size_t entrySize = sizeof(uint16_t) + 2 * sizeof(uint32_t) + sizeof(RicCoreUtil::DurationStats::summary_t);
+
+    bool passed = true;
+    passed &= check(buf.size() == sizeof(uint32_t) + 2 * entrySize, "serialized size");
+    passed &= check(readBytes<uint16_t>(buf, sizeof(uint32_t)) == 40 && readBytes<uint16_t>(buf, sizeof(uint32_t) + entrySize) == 63,
+                    "serialized profiles hold the state indices");
+    return passed;
+}
+
+static bool testWideFlagStates()
+{
+    std::cout << "wide_flag_states" << std::endl;
+
+    using trace_t = StateTrace<WIDE_STATES>;
+    static_assert(trace_t::N_STATES == 128, "wide trace sized by the number of wide flags");
+    trace_t trace;
+    StateMachine<WIDE_STATES> statemachine;
+    statemachine.addMonitor(trace);
+
+    // first -> second -> last
+    statemachine.initalize(std::make_unique<WideStepState>(WIDE_STATES::FIRST));
+    statemachine.update();
+    statemachine.update();
+
+    std::array<trace_t::event_t, 64> events;
+    const size_t count = trace.snapshot(events);
+
+    bool passed = true;
+    passed &= check(count == 3, "every transition recorded");
+    passed &= check(events[0].from == trace_t::NO_STATE && events[0].to == 0, "initial transition has no exited state");
+    passed &= check(events[1].from == 0 && events[1].to == 1 && events[2].from == 1 && events[2].to == 127, "states indexed by value");
+    passed &= check(trace.getStats(WIDE_STATES::FIRST).entries == 1 && trace.getStats(WIDE_STATES::SECOND).entries == 1 &&
+                        trace.getStats(WIDE_STATES::LAST).entries == 1,
+                    "state zero and state one kept apart");
+
+    std::vector<uint8_t> buf;
+    trace.serialize(buf);
+    const size_t statesOffset = sizeof(uint32_t) + count * trace_t::EVENT_SIZE;
+    const size_t statEntrySize = sizeof(trace_t::stateIndex_t) + sizeof(trace_t::state_stats_t);
+    passed &= check(readBytes<uint32_t>(buf, statesOffset) == 3 &&
+                        readBytes<uint16_t>(buf, statesOffset + sizeof(uint32_t)) == 0 &&
+                        readBytes<uint16_t>(buf, statesOffset + sizeof(uint32_t) + statEntrySize) == 1 &&
+                        readBytes<uint16_t>(buf, statesOffset + sizeof(uint32_t) + 2 * statEntrySize) == 127,
+                    "serialized stats hold the state values");
+
+    statemachine.exit();
+    return passed;
+}
+
+static bool testProfilerWideFlagStates()
+{
+    std::cout << "profiler_wide_flag_states" << std::endl;
+
+    StateProfiler<WIDE_STATES> profiler(widesystemstatus, WIDE_STATES::LAST);
+
+    bool passed = true;
+    passed &= check(!profiler.getWorstState().has_value(), "no worst state before profiling");
+
+    profiler.onUpdate(WIDE_STATES::FIRST, 30);
+    profiler.onUpdate(WIDE_STATES::LAST, 20);
+    passed &= check(profiler.getWorstState() == WIDE_STATES::FIRST, "state zero can be the worst state");
+
+    std::vector<uint8_t> buf;
+    profiler.serialize(buf);
+    const size_t entrySize = sizeof(uint16_t) + 2 * sizeof(uint32_t) + sizeof(RicCoreUtil::DurationStats::summary_t);
+    passed &= check(readBytes<uint16_t>(buf, sizeof(uint32_t)) == 0 && readBytes<uint16_t>(buf, sizeof(uint32_t) + entrySize) == 127,
+                    "serialized profiles hold the state values");
+    return passed;
+}
+
+int main()
+{
+    bool passed = true;
+    passed &= testHighFlagStates();
+    passed &= testProfilerHighFlagStates();
+    passed &= testWideFlagStates();
+    passed &= testProfilerWideFlagStates();
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
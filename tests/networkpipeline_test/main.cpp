@@ -0,0 +1,156 @@
+/**
+ * @brief Test of the network pipeline mode. The SpscQueue is stressed with a producer and consumer thread, then a
+ * PipelinedNetworkManager with a loopback interface is run with the pipeline started. Packets are sent from the
+ * control loop (main thread), looped back by the interface on the network thread, and the service callback must be
+ * called back on the control loop.
+ *
+ */
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <queue>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+#include <librnp/rnp_interface.h>
+#include <librnp/rnp_packet.h>
+#include <librnp/default_packets/simplecommandpacket.h>
+
+#include <libriccore/threading/spscqueue.h>
+#include <libriccore/networkinterfaces/pipelinednetworkmanager.h>
+
+static constexpr uint8_t echoService = 10;
+static constexpr size_t numPackets = 1000;
+
+/**
+ * @brief Interface which receives every packet it sends
+ *
+ */
+class LoopbackInterface : public RnpInterface
+{
+public:
+    LoopbackInterface() : RnpInterface(static_cast<uint8_t>(DEFAULT_INTERFACES::LOOPBACK), "loopback")
+    {
+        _info.MTU = 256;
+    };
+
+    void setup() override{};
+
+    void sendPacket(RnpPacket &packet) override
+    {
+        std::vector<uint8_t> serialized;
+        packet.serialize(serialized);
+        _wire.push(std::make_unique<RnpPacketSerialized>(serialized));
+    };
+
+    void update() override
+    {
+        updateThread = std::this_thread::get_id();
+        while (!_wire.empty())
+        {
+            _wire.front()->header.src_iface = getID();
+            _packetBuffer->push(std::move(_wire.front()));
+            _wire.pop();
+        }
+    };
+
+    const RnpInterfaceInfo *getInfo() override { return &_info; };
+
+    std::atomic<std::thread::id> updateThread;
+
+private:
+    RnpInterfaceInfo _info;
+    std::queue<std::unique_ptr<RnpPacketSerialized>> _wire;
+};
+
+bool testSpscQueue()
+{
+    RicCoreThread::SpscQueue<uint32_t, 64> queue;
+    static constexpr uint32_t numItems = 1000000;
+
+    std::thread producer([&queue]()
+                         {
+        for (uint32_t i = 0; i < numItems;)
+        {
+            uint32_t item = i;
+            if (queue.push(std::move(item)))
+            {
+                ++i;
+            }
+        } });
+
+    bool ordered = true;
+    for (uint32_t expected = 0; expected < numItems;)
+    {
+        uint32_t item;
+        if (queue.pop(item))
+        {
+            ordered &= (item == expected);
+            ++expected;
+        }
+    }
+    producer.join();
+
+    std::cout << "SpscQueue: " << (ordered ? "in order" : "OUT OF ORDER") << std::endl;
+    return ordered && queue.empty();
+}
+
+bool testPipeline()
+{
+    PipelinedNetworkManager<> networkmanager(1, NODETYPE::LEAF, true, 200);
+    LoopbackInterface loopback;
+    networkmanager.addInterface(&loopback);
+    networkmanager.generateDefaultRoutes();
+
+    const std::thread::id controlThread = std::this_thread::get_id();
+    size_t received = 0;
+    bool callbackOnControlThread = true;
+
+    networkmanager.registerService(echoService, [&](packetptr_t packet)
+                                   {
+        callbackOnControlThread &= (std::this_thread::get_id() == controlThread);
+        ++received; });
+
+    networkmanager.startPipeline(0, 0, RicCoreThread::Thread::CORE_ID::CORE0, 1);
+
+    auto sendEcho = [&networkmanager](uint32_t arg)
+    {
+        SimpleCommandPacket packet(0, arg);
+        packet.header.source = 1;
+        packet.header.destination = 1;
+        packet.header.destination_service = echoService;
+        networkmanager.sendPacket(packet);
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t sent = 0;
+    while (received < numPackets && std::chrono::steady_clock::now() - start < std::chrono::seconds(10))
+    {
+        // keep a few packets in flight so the queues don't overflow
+        if (sent - received < 8 && sent < numPackets)
+        {
+            sendEcho(sent++);
+        }
+        networkmanager.update();
+    }
+
+    networkmanager.stopPipeline();
+
+    const bool networkOnOtherThread = loopback.updateThread.load() != controlThread;
+
+    std::cout << "Pipeline: received " << received << "/" << numPackets
+              << ", rx dropped " << networkmanager.getRxDropped()
+              << ", tx dropped " << networkmanager.getTxDropped()
+              << ", callbacks on control thread " << callbackOnControlThread
+              << ", interface updated on network thread " << networkOnOtherThread << std::endl;
+
+    return received == numPackets && callbackOnControlThread && networkOnOtherThread;
+}
+
+int main()
+{
+    const bool passed = testSpscQueue() && testPipeline();
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+/**
+ * @brief Benchmark of main loop timing stability. Three periodic tasks with busy work are run for a fixed time by
+ * an ad hoc loop where each task does its own millis() delta check (the pattern the scheduler replaces), by the
+ * TaskScheduler busy looping, and by the TaskScheduler with idle yield. For each task the error of the interval
+ * between consecutive starts from the task period is reported, along with the cpu time used by the loop.
+ * The scheduler keeps the phase of a late task so one late start gives a long then a short interval, counted twice,
+ * where the ad hoc loop restarts its period from the late start and counts it once. Compare the scheduler release
+ * jitter (start time - release time) between the busy loop and idle yield runs rather than against the ad hoc loop.
+ *
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <ctime>
+#include <array>
+#include <string>
+
+#include <libriccore/scheduling/taskscheduler.h>
+#include <libriccore/platform/millis.h>
+#include <libriccore/util/durationstats.h>
+
+static constexpr uint32_t runTime = 3000; // [ms]
+
+struct BenchTask
+{
+    const char *name;
+    uint32_t period;    // [us]
+    uint32_t busyTime;  // [us]
+};
+
+static constexpr std::array<BenchTask, 3> benchTasks{{{"500Hz", 2000, 50},
+                                                      {"100Hz", 10000, 300},
+                                                      {"10Hz", 100000, 1000}}};
+
+struct TaskRecord
+{
+    uint32_t lastStart = 0;
+    bool started = false;
+    RicCoreUtil::DurationStats intervalError;
+};
+
+static void busyWait(uint32_t duration)
+{
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::microseconds(duration))
+    {
+    }
+}
+
+/**
+ * @brief Run a benchmark task, recording the error of the interval since the previous start
+ *
+ */
+static void runTask(const BenchTask &task, TaskRecord &record)
+{
+    const uint32_t now = micros();
+    if (record.started)
+    {
+        const int32_t error = static_cast<int32_t>((now - record.lastStart) - task.period);
+        record.intervalError.record(static_cast<uint32_t>(error < 0 ? -error : error));
+    }
+    record.started = true;
+    record.lastStart = now;
+    busyWait(task.busyTime);
+}
+
+static void report(const std::string &name, const std::array<TaskRecord, 3> &records, double cpuTime)
+{
+    std::cout << name << " (cpu " << std::fixed << std::setprecision(1) << 100.0 * cpuTime / (runTime / 1000.0) << "%)\n";
+    for (size_t i = 0; i < benchTasks.size(); i++)
+    {
+        const RicCoreUtil::DurationStats &stats = records[i].intervalError;
+        std::cout << "  " << std::setw(6) << benchTasks[i].name
+                  << " runs " << std::setw(5) << stats.count()
+                  << " interval error us: mean " << std::setw(5) << stats.mean()
+                  << " p99 " << std::setw(5) << stats.percentile(0.99f)
+                  << " max " << std::setw(5) << stats.max() << "\n";
+    }
+}
+
+template <typename F>
+static double runLoop(F &&loop)
+{
+    const std::clock_t cpuStart = std::clock();
+    const uint32_t start = millis();
+    while (millis() - start < runTime)
+    {
+        loop();
+    }
+    return static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+}
+
+int main()
+{
+    // ad hoc millis() delta checks
+    {
+        std::array<TaskRecord, 3> records;
+        std::array<uint32_t, 3> lastRun{};
+        const double cpuTime = runLoop([&]()
+                                       {
+            for (size_t i = 0; i < benchTasks.size(); i++)
+            {
+                if (millis() - lastRun[i] >= benchTasks[i].period / 1000)
+                {
+                    lastRun[i] = millis();
+                    runTask(benchTasks[i], records[i]);
+                }
+            } });
+        report("millis() delta checks", records, cpuTime);
+    }
+
+    // scheduler, busy loop and idle yield
+    for (const bool idleYield : {false, true})
+    {
+        std::array<TaskRecord, 3> records;
+        TaskScheduler<> scheduler;
+        for (size_t i = 0; i < benchTasks.size(); i++)
+        {
+            scheduler.addTask([&records, i]()
+                              { runTask(benchTasks[i], records[i]); },
+                              benchTasks[i].period);
+        }
+        if (idleYield)
+        {
+            scheduler.setIdleYield(10);
+        }
+        const double cpuTime = runLoop([&]()
+                                       { scheduler.update(); });
+        report(idleYield ? "TaskScheduler idle yield" : "TaskScheduler busy loop", records, cpuTime);
+
+        for (size_t i = 0; i < benchTasks.size(); i++)
+        {
+            std::cout << "  " << std::setw(6) << benchTasks[i].name
+                      << " release jitter us: p99 " << std::setw(5) << scheduler.getJitterStats(i).percentile(0.99f)
+                      << " overruns " << scheduler.getOverruns(i)
+                      << " missed " << scheduler.getMissedReleases(i) << "\n";
+        }
+        if (idleYield)
+        {
+            std::cout << "  idle time " << scheduler.getIdleTime() / 1000 << " ms\n";
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,309 @@
+/**
+ * @brief Checks the atomic flag manager behind SystemStatus. newFlag and deleteFlag must only report a change on an
+ * edge, and flags raised and removed concurrently from several threads must never lose an update to another flag.
+ * Checks that SystemStatus subscribers only see edges of their masked flags, that the flag history keeps the latest
+ * HISTORY_SIZE changes, and that subscribing while other threads change flags is safe.
+ * Checks the wide flag manager selected through WideFlags for flag sets with more than 64 flags.
+ *
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#include <libriccore/systemstatus/systemstatus.h>
+#include <libriccore/systemstatus/atomicbitwiseflagmanager.h>
+
+enum class TEST_FLAGS : uint32_t
+{
+    A = (1 << 0),
+    B = (1 << 1),
+    C = (1 << 2),
+    D = (1 << 3)
+};
+
+using Flags = TEST_FLAGS;
+
+enum class WIDE_FLAGS : uint8_t
+{
+    A = 0,
+    B = 31,
+    C = 32,
+    D = 100,
+    E = 127
+};
+
+template <>
+struct WideFlags<WIDE_FLAGS> : std::integral_constant<size_t, 128>
+{
+};
+
+using Wide = WIDE_FLAGS;
+
+static_assert(WideBitwiseFlagManager<Wide, 128>::mask(Wide::A, Wide::D)[0] == 1 &&
+                  WideBitwiseFlagManager<Wide, 128>::mask(Wide::A, Wide::D)[3] == (1u << 4),
+              "wide mask sets the bit of each flag index");
+
+static bool check(bool condition, const std::string &description)
+{
+    std::cout << (condition ? "  ok   " : "  FAIL ") << description << std::endl;
+    return condition;
+}
+
+static bool testEdges()
+{
+    std::cout << "edges" << std::endl;
+
+    AtomicBitwiseFlagManager<Flags> flags;
+    bool passed = true;
+    passed &= check(flags.newFlag(Flags::A), "raising a cleared flag is an edge");
+    passed &= check(!flags.newFlag(Flags::A), "raising a raised flag is not an edge");
+    passed &= check(flags.deleteFlag(Flags::A), "removing a raised flag is an edge");
+    passed &= check(!flags.deleteFlag(Flags::A), "removing a cleared flag is not an edge");
+    passed &= check(!flags.deleteFlag(Flags::B) && flags.getStatus() == 0, "removing a never raised flag is not an edge");
+
+    SystemStatus<Flags> systemstatus;
+    systemstatus.newFlag(Flags::C, "raised");
+    systemstatus.newFlag(Flags::C, "raised again");
+    passed &= check(systemstatus.flagSet(Flags::C) && !systemstatus.flagSetOr(Flags::A, Flags::B, Flags::D), "SystemStatus raises only the given flag");
+    systemstatus.deleteFlag(Flags::C);
+    passed &= check(systemstatus.getStatus() == 0, "SystemStatus removes the flag");
+    return passed;
+}
+
+static bool testConcurrentFlags()
+{
+    std::cout << "concurrent_flags" << std::endl;
+
+    static constexpr int iterations = 20000;
+    const Flags threadFlags[] = {Flags::A, Flags::B, Flags::C, Flags::D};
+
+    AtomicBitwiseFlagManager<Flags> flags;
+    std::atomic<int> badEdges{0};
+    std::vector<std::thread> threads;
+
+    // each thread toggles its own flag, a lost update would show as a missing edge or a flag in the wrong state
+    for (Flags flag : threadFlags)
+    {
+        threads.emplace_back([&flags, &badEdges, flag]()
+                             {
+                                 for (int i = 0; i < iterations; i++)
+                                 {
+                                     if (!flags.newFlag(flag) || !flags.flagSet(flag))
+                                     {
+                                         ++badEdges;
+                                     }
+                                     if (!flags.deleteFlag(flag) || flags.flagSet(flag))
+                                     {
+                                         ++badEdges;
+                                     }
+                                 }
+                                 flags.newFlag(flag); });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    bool passed = true;
+    passed &= check(badEdges == 0, "every raise and remove reported as an edge");
+    passed &= check(flags.flagSetAnd(Flags::A, Flags::B, Flags::C, Flags::D), "final raise of every thread kept");
+    return passed;
+}
+
+static bool testSubscriptions()
+{
+    std::cout << "subscriptions" << std::endl;
+
+    SystemStatus<Flags> systemstatus;
+    int edges = 0;
+    bool lastRaised = false;
+    bool onlyMasked = true;
+    size_t id = systemstatus.subscribe([&](Flags flag, bool raised)
+                                       {
+                                           ++edges;
+                                           lastRaised = raised;
+                                           onlyMasked &= (flag == Flags::A || flag == Flags::B); },
+                                       Flags::A, Flags::B);
+
+    systemstatus.newFlag(Flags::A);
+    systemstatus.newFlag(Flags::A);
+    systemstatus.newFlag(Flags::C);
+    systemstatus.deleteFlag(Flags::A);
+    systemstatus.deleteFlag(Flags::A);
+
+    bool passed = true;
+    passed &= check(edges == 2 && !lastRaised, "subscriber called on edges only");
+    passed &= check(onlyMasked, "subscriber not called for unmasked flags");
+
+    systemstatus.unsubscribe(id);
+    systemstatus.newFlag(Flags::B);
+    passed &= check(edges == 2, "unsubscribed callback not called");
+
+    for (size_t i = 1; i < SystemStatus<Flags>::MAX_SUBSCRIBERS; i++)
+    {
+        systemstatus.subscribe([](Flags, bool) {}, Flags::D);
+    }
+    bool threw = false;
+    try
+    {
+        systemstatus.subscribe([](Flags, bool) {}, Flags::D);
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    passed &= check(threw, "subscribing past MAX_SUBSCRIBERS throws");
+    return passed;
+}
+
+static bool testConcurrentSubscribe()
+{
+    std::cout << "concurrent_subscribe" << std::endl;
+
+    static constexpr size_t subscribers = SystemStatus<Flags>::MAX_SUBSCRIBERS;
+
+    SystemStatus<Flags> systemstatus;
+    std::array<std::atomic<int>, subscribers> edges{};
+    std::atomic<bool> stop{false};
+
+    // flags change on another thread while the subscriptions are made
+    std::thread toggler([&systemstatus, &stop]()
+                        {
+                            while (!stop)
+                            {
+                                systemstatus.newFlag(Flags::A);
+                                systemstatus.deleteFlag(Flags::A);
+                            } });
+
+    for (size_t i = 0; i < subscribers; i++)
+    {
+        systemstatus.subscribe([&edges, i](Flags, bool)
+                               { ++edges[i]; },
+                               Flags::A);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // every subscriber must see the edges made after its subscribe returned
+    std::array<int, subscribers> before;
+    for (size_t i = 0; i < subscribers; i++)
+    {
+        before[i] = edges[i];
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    stop = true;
+    toggler.join();
+
+    bool passed = true;
+    bool allCalled = true;
+    for (size_t i = 0; i < subscribers; i++)
+    {
+        allCalled &= (edges[i] > before[i]);
+    }
+    passed &= check(allCalled, "every subscription made while flags change is called");
+    return passed;
+}
+
+static bool testHistory()
+{
+    std::cout << "history" << std::endl;
+
+    using status_t = SystemStatus<Flags>;
+    status_t systemstatus;
+    std::array<status_t::flag_event_t, status_t::HISTORY_SIZE> history;
+
+    systemstatus.newFlag(Flags::A);
+    systemstatus.newFlag(Flags::A);
+    systemstatus.newFlag(Flags::C);
+    systemstatus.deleteFlag(Flags::A);
+
+    bool passed = true;
+    size_t count = systemstatus.getHistory(history);
+    passed &= check(count == 3 && history[0].flag == static_cast<uint32_t>(Flags::A) && history[1].flag == static_cast<uint32_t>(Flags::C),
+                    "only edges recorded, oldest first");
+    passed &= check(!history[2].raised && history[2].status == static_cast<uint32_t>(Flags::C), "entry holds the status after the change");
+
+    for (int i = 0; i < 40; i++)
+    {
+        systemstatus.newFlag(Flags::B);
+        systemstatus.deleteFlag(Flags::B);
+    }
+    count = systemstatus.getHistory(history);
+    passed &= check(count == status_t::HISTORY_SIZE && systemstatus.getChangeCount() == 83, "history keeps the latest changes and counts all");
+    passed &= check(history[status_t::HISTORY_SIZE - 1].flag == static_cast<uint32_t>(Flags::B) && !history[status_t::HISTORY_SIZE - 1].raised,
+                    "newest change last");
+
+    std::vector<uint8_t> buf;
+    systemstatus.serialize(buf);
+    passed &= check(buf.size() == 4 + status_t::HISTORY_SIZE * 17, "serialized history size");
+    return passed;
+}
+
+static bool testWideFlags()
+{
+    std::cout << "wide_flags" << std::endl;
+
+    using status_t = SystemStatus<Wide>;
+    status_t systemstatus;
+    int edges = 0;
+    bool onlyMasked = true;
+    systemstatus.subscribe([&](Wide flag, bool)
+                           {
+                               ++edges;
+                               onlyMasked &= (flag == Wide::D); },
+                           Wide::D);
+
+    systemstatus.newFlag(Wide::A);
+    systemstatus.newFlag(Wide::D);
+    systemstatus.newFlag(Wide::D, "again");
+
+    bool passed = true;
+    passed &= check(systemstatus.flagSet(Wide::D) && !systemstatus.flagSet(Wide::C), "flags above bit 63 raised individually");
+    passed &= check(systemstatus.flagSetOr(Wide::C, Wide::E, Wide::D) && !systemstatus.flagSetOr(Wide::B, Wide::C), "flagSetOr across words");
+    passed &= check(systemstatus.flagSetAnd(Wide::A, Wide::D) && !systemstatus.flagSetAnd(Wide::A, Wide::D, Wide::E), "flagSetAnd across words");
+    passed &= check(systemstatus.flagSetOr(systemstatus.generateFlags({Wide::E, Wide::A})), "flagSetOr with a generated mask");
+    passed &= check(systemstatus.getStatusBitset().count() == 2 && systemstatus.getStatusBitset()[100], "status bitset holds the raised flags");
+
+    systemstatus.deleteFlag(Wide::D);
+    passed &= check(edges == 2 && onlyMasked, "subscriber called on edges of its flag only");
+
+    std::array<status_t::flag_event_t, status_t::HISTORY_SIZE> history;
+    size_t count = systemstatus.getHistory(history);
+    passed &= check(count == 3 && history[1].status[3] == (1u << 4) && history[2].status[3] == 0, "history holds the full status words");
+
+    std::vector<uint8_t> buf;
+    systemstatus.serialize(buf);
+    passed &= check(buf.size() == 4 + 3 * (8 + 1 + 16 + 1), "serialized history size");
+
+    bool threw = false;
+    try
+    {
+        systemstatus.newFlag(static_cast<Wide>(128));
+    }
+    catch (const std::out_of_range &)
+    {
+        threw = true;
+    }
+    passed &= check(threw, "flag index past the width throws");
+    return passed;
+}
+
+int main()
+{
+    bool passed = true;
+    passed &= testEdges();
+    passed &= testConcurrentFlags();
+    passed &= testSubscriptions();
+    passed &= testConcurrentSubscribe();
+    passed &= testHistory();
+    passed &= testWideFlags();
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+/**
+ * @brief Checks RicCoreThread::Thread on unix applies the requested core affinity, stack size, name and priority.
+ * Threads pinned to CORE0 and (if the machine has a second cpu) CORE1 must only be allowed on and run on that cpu,
+ * an ANYCORE thread must keep the process affinity. The priority is checked against SCHED_FIFO when it is at least
+ * LIBRICCORE_UNIX_RT_PRIORITY, otherwise against the nice value, and reported when neither is permitted. A StaticThread must run on the stack held inside the thread object. A timed
+ * join must time out while the thread is running and succeed once it has returned.
+ *
+ */
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+#include <libriccore/threading/riccorethread.h>
+#include <libriccore/platform/riccorethread_types.h>
+
+using namespace RicCoreThread;
+
+struct Placement
+{
+    cpu_set_t affinity;
+    int cpu;
+    size_t stackSize;
+    char name[16];
+    int policy;
+    int priority;
+    int nice;
+};
+
+static void recordPlacement(void *arg)
+{
+    Placement &placement = *static_cast<Placement *>(arg);
+
+    pthread_getaffinity_np(pthread_self(), sizeof(placement.affinity), &placement.affinity);
+    placement.cpu = sched_getcpu();
+
+    pthread_attr_t attr;
+    pthread_getattr_np(pthread_self(), &attr);
+    pthread_attr_getstacksize(&attr, &placement.stackSize);
+    pthread_attr_destroy(&attr);
+
+    pthread_getname_np(pthread_self(), placement.name, sizeof(placement.name));
+
+    sched_param param;
+    pthread_getschedparam(pthread_self(), &placement.policy, &param);
+    placement.priority = param.sched_priority;
+    placement.nice = getpriority(PRIO_PROCESS, 0);
+}
+
+static bool check(bool condition, const std::string &description)
+{
+    std::cout << (condition ? "  ok   " : "  FAIL ") << description << std::endl;
+    return condition;
+}
+
+static bool testThread(Thread::CORE_ID core, const std::string &name, size_t stackSize, int priority)
+{
+    std::cout << name << std::endl;
+
+    Placement placement{};
+    Thread thread(recordPlacement, &placement, stackSize, priority, core, name);
+    thread.join();
+    thread.join(); // joining twice must be safe
+
+    bool passed = true;
+
+    cpu_set_t processAffinity;
+    sched_getaffinity(0, sizeof(processAffinity), &processAffinity);
+    if (core == Thread::CORE_ID::ANYCORE)
+    {
+        passed &= check(CPU_EQUAL(&placement.affinity, &processAffinity), "affinity is the process affinity");
+    }
+    else
+    {
+        const int cpu = static_cast<int>(core);
+        passed &= check(CPU_COUNT(&placement.affinity) == 1 && CPU_ISSET(cpu, &placement.affinity), "affinity is cpu " + std::to_string(cpu));
+        passed &= check(placement.cpu == cpu, "ran on cpu " + std::to_string(cpu));
+    }
+
+    passed &= check(placement.stackSize >= stackSize, "stack size " + std::to_string(placement.stackSize) + " >= " + std::to_string(stackSize));
+    passed &= check(name.substr(0, 15) == placement.name, "name is " + std::string(placement.name));
+
+    const bool realtime = LIBRICCORE_UNIX_RT_PRIORITY > 0 && priority >= LIBRICCORE_UNIX_RT_PRIORITY;
+    if (priority == 0)
+    {
+        passed &= check(placement.policy == SCHED_OTHER && placement.nice == 0, "default scheduling");
+    }
+    else if (!realtime && placement.policy == SCHED_FIFO)
+    {
+        passed &= check(false, "SCHED_FIFO below LIBRICCORE_UNIX_RT_PRIORITY");
+    }
+    else if (placement.policy == SCHED_FIFO)
+    {
+        passed &= check(placement.priority == priority, "SCHED_FIFO priority " + std::to_string(placement.priority));
+    }
+    else if (placement.nice != 0)
+    {
+        passed &= check(placement.nice == -priority, "nice value " + std::to_string(placement.nice));
+    }
+    else
+    {
+        std::cout << "  note no privileges for SCHED_FIFO or negative nice, default scheduling kept" << std::endl;
+    }
+    return passed;
+}
+
+struct StaticPlacement
+{
+    Placement placement;
+    uintptr_t stackAddress;
+};
+
+static void recordStaticPlacement(void *arg)
+{
+    StaticPlacement &staticPlacement = *static_cast<StaticPlacement *>(arg);
+    int local = 0;
+    staticPlacement.stackAddress = reinterpret_cast<uintptr_t>(&local);
+    recordPlacement(&staticPlacement.placement);
+}
+
+/**
+ * @brief A StaticThread must run on the stack inside the thread object, and apply the affinity and name
+ *
+ */
+static bool testStaticThread()
+{
+    std::cout << "static_thread" << std::endl;
+
+    static constexpr size_t stackSize = 1 << 20;
+    StaticPlacement staticPlacement{};
+    auto thread = std::make_unique<StaticThread<stackSize>>(recordStaticPlacement, &staticPlacement, 0, Thread::CORE_ID::CORE0, "static_thread");
+    thread->join();
+
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(thread.get());
+    const uintptr_t end = begin + sizeof(*thread);
+
+    bool passed = true;
+    passed &= check(staticPlacement.stackAddress >= begin && staticPlacement.stackAddress < end, "stack is inside the thread object");
+    passed &= check(CPU_COUNT(&staticPlacement.placement.affinity) == 1 && CPU_ISSET(0, &staticPlacement.placement.affinity), "affinity is cpu 0");
+    passed &= check(std::string(staticPlacement.placement.name) == "static_thread", "name is " + std::string(staticPlacement.placement.name));
+    return passed;
+}
+
+static void waitForGate(void *arg)
+{
+    static_cast<Event_t *>(arg)->wait();
+}
+
+/**
+ * @brief join(timeout) must return false while the thread is blocked on the gate, and true once it has returned
+ *
+ */
+static bool testJoinTimeout()
+{
+    std::cout << "join_timeout" << std::endl;
+
+    bool passed = true;
+    {
+        Event_t gate;
+        Thread thread(waitForGate, &gate, 0, 0, Thread::CORE_ID::ANYCORE, "join_timeout");
+        passed &= check(!thread.join(20), "thread join times out while running");
+        gate.set();
+        passed &= check(thread.join(1000), "thread join succeeds after return");
+        passed &= check(thread.join(0), "thread join succeeds when already joined");
+    }
+    {
+        Event_t gate;
+        StaticThread<1 << 20> thread(waitForGate, &gate, 0, Thread::CORE_ID::ANYCORE, "join_timeout");
+        passed &= check(!thread.join(20), "static thread join times out while running");
+        gate.set();
+        passed &= check(thread.join(1000), "static thread join succeeds after return");
+    }
+    return passed;
+}
+
+int main()
+{
+    cpu_set_t processAffinity;
+    sched_getaffinity(0, sizeof(processAffinity), &processAffinity);
+
+    bool passed = true;
+    if (CPU_ISSET(0, &processAffinity))
+    {
+        passed &= testThread(Thread::CORE_ID::CORE0, "placement_core0", 1 << 20, 5);
+    }
+    if (CPU_ISSET(1, &processAffinity))
+    {
+        passed &= testThread(Thread::CORE_ID::CORE1, "placement_core1", 1 << 21, 10);
+    }
+    else
+    {
+        std::cout << "cpu 1 not available, CORE1 placement not tested" << std::endl;
+    }
+    passed &= testThread(Thread::CORE_ID::ANYCORE, "placement_anycore_long_name", 256 * 1024, 0);
+    passed &= testStaticThread();
+    passed &= testJoinTimeout();
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+/**
+ * @brief Benchmark of ThreadPool scaling. A checksum verification workload (crc32 over independent blocks, submitted
+ * from outside the pool) and a recursive divide and conquer sum (tasks submitting and waiting on subtasks, which
+ * exercises work stealing) are run with an increasing number of workers up to the number of hardware threads.
+ * Results are checked against a serial run, and the time and speedup over a single worker are reported. The maximum
+ * number of workers can be passed as the first argument.
+ *
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <thread>
+#include <array>
+#include <numeric>
+#include <string>
+
+#include <libriccore/threading/threadpool.h>
+
+static constexpr size_t numBlocks = 256;
+static constexpr size_t blockSize = 64 * 1024;
+static constexpr size_t sumLength = 1 << 24;
+static constexpr size_t sumGrain = 1 << 14;
+
+using namespace RicCoreThread;
+
+static std::array<uint32_t, 256> crcTable()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+static const std::array<uint32_t, 256> table = crcTable();
+
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Sum a range, splitting it in half and submitting one half as a subtask until the grain size is reached
+ *
+ */
+static uint64_t parallelSum(ThreadPool &pool, const uint32_t *data, size_t length)
+{
+    if (length <= sumGrain)
+    {
+        return std::accumulate(data, data + length, uint64_t(0));
+    }
+    const size_t half = length / 2;
+    TaskFuture<uint64_t> upper = pool.submit([&pool, data, half, length]()
+                                             { return parallelSum(pool, data + half, length - half); });
+    const uint64_t lower = parallelSum(pool, data, half);
+    return lower + upper.get();
+}
+
+template <typename F>
+static double timeMs(F &&f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    std::mt19937 rng(42);
+    std::vector<std::vector<uint8_t>> blocks(numBlocks, std::vector<uint8_t>(blockSize));
+    for (auto &block : blocks)
+    {
+        for (auto &byte : block)
+        {
+            byte = static_cast<uint8_t>(rng());
+        }
+    }
+    std::vector<uint32_t> values(sumLength);
+    for (auto &value : values)
+    {
+        value = rng();
+    }
+
+    // serial reference
+    std::vector<uint32_t> expectedCrcs(numBlocks);
+    for (size_t i = 0; i < numBlocks; i++)
+    {
+        expectedCrcs[i] = crc32(blocks[i].data(), blockSize);
+    }
+    const uint64_t expectedSum = std::accumulate(values.begin(), values.end(), uint64_t(0));
+
+    const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    // the maximum number of workers can be overridden, e.g to check correctness on a machine with few cores
+    const size_t maxWorkers = (argc > 1) ? std::stoul(argv[1]) : hardwareThreads;
+    std::cout << "hardware threads: " << hardwareThreads << std::endl;
+    std::cout << std::setw(8) << "workers" << std::setw(14) << "crc [ms]" << std::setw(10) << "speedup"
+              << std::setw(14) << "sum [ms]" << std::setw(10) << "speedup" << std::setw(10) << "steals" << std::endl;
+
+    bool passed = true;
+    double crcBaseline = 0;
+    double sumBaseline = 0;
+    for (size_t workers = 1; workers <= maxWorkers; workers *= 2)
+    {
+        ThreadPool pool(workers);
+
+        std::vector<uint32_t> crcs(numBlocks);
+        const double crcTime = timeMs([&]()
+                                      {
+                                          std::vector<TaskFuture<uint32_t>> futures;
+                                          futures.reserve(numBlocks);
+                                          for (size_t i = 0; i < numBlocks; i++)
+                                          {
+                                              futures.push_back(pool.submit([&blocks, i]()
+                                                                            { return crc32(blocks[i].data(), blockSize); }));
+                                          }
+                                          for (size_t i = 0; i < numBlocks; i++)
+                                          {
+                                              crcs[i] = futures[i].get();
+                                          } });
+
+        uint64_t sum = 0;
+        const double sumTime = timeMs([&]()
+                                      { sum = pool.submit([&pool, &values]()
+                                                          { return parallelSum(pool, values.data(), values.size()); })
+                                                    .get(); });
+
+        if (crcs != expectedCrcs || sum != expectedSum)
+        {
+            std::cout << "Result mismatch with " << workers << " workers!" << std::endl;
+            passed = false;
+        }
+
+        if (workers == 1)
+        {
+            crcBaseline = crcTime;
+            sumBaseline = sumTime;
+        }
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(8) << workers
+                  << std::setw(14) << crcTime << std::setw(9) << crcBaseline / crcTime << "x"
+                  << std::setw(14) << sumTime << std::setw(9) << sumBaseline / sumTime << "x"
+                  << std::setw(10) << pool.getSteals() << std::endl;
+    }
+
+    // exceptions thrown by a task are rethrown by get
+    {
+        ThreadPool pool(2);
+        TaskFuture<void> future = pool.submit([]()
+                                              { throw std::runtime_error("task failed"); });
+        try
+        {
+            future.get();
+            std::cout << "Task exception not propagated!" << std::endl;
+            passed = false;
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+    }
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}